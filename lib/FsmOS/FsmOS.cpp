@@ -19,6 +19,63 @@
 /* ================== Memory Tracking ================== */
 #if !defined(FSMOS_DISABLE_LEAK_DETECTION)
 MemoryStats fsmos_memory_stats = {0, 0, 0, 0};
+
+#if defined(__AVR__)
+#include <new>  // std::nothrow_t
+
+/**
+ * @brief Counting operator new/delete
+ * 
+ * Replaces every form the Arduino core's new.cpp defines, nothrow ones
+ * included, so that object is never linked and no allocation or free
+ * bypasses the counters. Allocations are charged to the task in
+ * reset_info.last_task_id, which the scheduler sets before each step()
+ * and on_msg(). Static constructors run while the slot table
+ * is still empty and begin() clears the ID, so nothing allocated before
+ * the first task runs is charged; anything allocated between calls goes
+ * to the task that ran last.
+ */
+struct HeapHooks {
+  // avr-libc's malloc keeps the chunk size just below the block
+  static uint16_t chunk_size(void* p) { return ((size_t*)p)[-1]; }
+
+  static void* allocate(size_t size) {
+    void* p = malloc(size);
+    if (!p) return nullptr;
+    uint16_t bytes = chunk_size(p);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      fsmos_memory_stats.allocations++;
+      fsmos_memory_stats.current_bytes += bytes;
+      if (fsmos_memory_stats.current_bytes > fsmos_memory_stats.peak_bytes) {
+        fsmos_memory_stats.peak_bytes = fsmos_memory_stats.current_bytes;
+      }
+      OS.charge_allocation(bytes);
+    }
+    return p;
+  }
+
+  static void release(void* p) {
+    if (!p) return;
+    uint16_t bytes = chunk_size(p);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      fsmos_memory_stats.deallocations++;
+      fsmos_memory_stats.current_bytes -= bytes;
+    }
+    free(p);
+  }
+};
+
+void* operator new(size_t size) { return HeapHooks::allocate(size); }
+void* operator new[](size_t size) { return HeapHooks::allocate(size); }
+void operator delete(void* p) { HeapHooks::release(p); }
+void operator delete[](void* p) { HeapHooks::release(p); }
+void operator delete(void* p, size_t) { HeapHooks::release(p); }
+void operator delete[](void* p, size_t) { HeapHooks::release(p); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return HeapHooks::allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return HeapHooks::allocate(size); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { HeapHooks::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { HeapHooks::release(p); }
+#endif
 #endif
 
 /* ================== Global OS Instance ================== */
@@ -29,6 +86,169 @@ Scheduler OS;
 __attribute__((section(".noinit")))
 ResetInfo reset_info;
 
+/* ================== Flight Recorder ================== */
+#if FSMOS_TRACE_SIZE
+// Also in .noinit; the magic number tells a trace that survived a reset
+// from the random contents RAM has after power-on
+struct TraceBuffer {
+  uint16_t magic;
+  uint8_t head;    // Next record to write
+  uint8_t count;   // Valid records, at most FSMOS_TRACE_SIZE
+  uint8_t frozen;  // Holds the events before a watchdog/brown-out reset
+  TraceRecord records[FSMOS_TRACE_SIZE];
+};
+
+static const uint16_t TRACE_MAGIC = 0x7E3C;
+
+__attribute__((section(".noinit")))
+static TraceBuffer trace_buf;
+
+/**
+ * @brief Append an event to the flight recorder
+ * 
+ * Called on the scheduler's hot paths, so it only stores four bytes;
+ * the host decoder (extras/trace_decode.py) does the rest.
+ */
+static inline void trace(uint8_t event, uint8_t id, uint8_t arg) {
+  if (trace_buf.frozen) return;
+  // Masked because a log call before begin() finds head uninitialized
+  TraceRecord& r = trace_buf.records[trace_buf.head & (FSMOS_TRACE_SIZE - 1)];
+  r.stamp = ((uint16_t)event << 13) | ((uint16_t)millis() & 0x1FFF);
+  r.id = id;
+  r.arg = arg;
+  trace_buf.head = (trace_buf.head + 1) & (FSMOS_TRACE_SIZE - 1);
+  if (trace_buf.count < FSMOS_TRACE_SIZE) trace_buf.count++;
+}
+
+/**
+ * @brief Keep or discard the trace found in RAM at boot
+ * 
+ * A trace is frozen after a watchdog or brown-out reset and stays frozen
+ * through further resets (such as the one opening the serial port
+ * causes) until restart_trace().
+ */
+static void init_trace(uint8_t reset_reason) {
+  bool valid = trace_buf.magic == TRACE_MAGIC && trace_buf.head < FSMOS_TRACE_SIZE &&
+               trace_buf.count <= FSMOS_TRACE_SIZE && trace_buf.frozen <= 1;
+#if defined(__AVR__)
+  if (valid && trace_buf.count && (reset_reason & (_BV(WDRF) | _BV(BORF)))) {
+    trace_buf.frozen = 1;
+  }
+#else
+  (void)reset_reason;
+#endif
+  if (!valid || !trace_buf.frozen) {
+    trace_buf.magic = TRACE_MAGIC;
+    trace_buf.head = 0;
+    trace_buf.count = 0;
+    trace_buf.frozen = 0;
+  }
+  reset_info.trace_count = trace_buf.frozen ? trace_buf.count : 0;
+}
+#else
+static inline void trace(uint8_t, uint8_t, uint8_t) {}
+#endif
+
+
+/* ================== Stack Painting ================== */
+#if defined(__AVR__)
+// Memory markers
+static const uint8_t HEAP_FREE_MARKER = 0xFF;
+static const uint8_t STACK_PAINT = 0xC5;      // Stack bytes not written since they were painted (see paint_stack())
+
+/**
+ * @brief Paint all RAM above the static data before main() runs
+ * 
+ * Lives in .init1, before the C runtime sets up the stack pointer, so
+ * it is plain assembly that touches no stack. .noinit ends below _end
+ * and keeps its contents.
+ */
+static void paint_stack() __attribute__((naked, used, section(".init1")));
+static void paint_stack() {
+  // Basic asm only, as GCC requires in naked functions; 0xC5 is STACK_PAINT
+  asm volatile(
+    "  ldi r30, lo8(_end)\n"
+    "  ldi r31, hi8(_end)\n"
+    "  ldi r24, 0xC5\n"
+    "  ldi r25, hi8(__stack)\n"
+    "  rjmp 2f\n"
+    "1: st Z+, r24\n"
+    "2: cpi r30, lo8(__stack)\n"
+    "  cpc r31, r25\n"
+    "  brlo 1b\n"
+    "  breq 1b\n");
+}
+
+/** @brief First address above the heap, the lowest the stack can reach */
+static inline uint16_t heap_end() {
+  extern int __heap_start, *__brkval;
+  return __brkval ? (uint16_t)__brkval : (uint16_t)&__heap_start;
+}
+
+/** @brief Lowest byte in [from, limit) that is not paint, or limit */
+static uint16_t first_used(uint16_t from, uint16_t limit) {
+  const uint8_t* p = (const uint8_t*)from;
+  while ((uint16_t)p < limit && *p == STACK_PAINT) p++;
+  return (uint16_t)p;
+}
+
+/**
+ * @brief Lowest stack byte in use at or below an address
+ * 
+ * Walks down from top and stops at FSMOS_STACK_SCAN_SLACK paint bytes in
+ * a row (or at floor), so the cost follows how deep the stack went, not
+ * the size of the free area. Always inlined, so its own frame is not
+ * mistaken for the stack being measured.
+ * 
+ * @return Lowest non-paint byte found, or top + 1 if none
+ */
+static inline __attribute__((always_inline)) uint16_t stack_reach(uint16_t top, uint16_t floor) {
+  const uint8_t* p = (const uint8_t*)top + 1;
+  uint8_t run = 0;
+  while ((uint16_t)p > floor && run < FSMOS_STACK_SCAN_SLACK) {
+    p--;
+    run = (*p == STACK_PAINT) ? run + 1 : 0;
+  }
+  return (uint16_t)p + run;
+}
+
+/**
+ * @brief Paint from an address up to the current stack pointer
+ * 
+ * Always inlined, so it never paints over its own frame; everything
+ * below SP is free.
+ */
+static inline __attribute__((always_inline)) void repaint_stack(uint16_t from) {
+  uint8_t* p = (uint8_t*)from;
+  uint8_t* end = (uint8_t*)SP;
+  while (p < end) *p++ = STACK_PAINT;
+}
+#endif
+
+/* ================== Message References ================== */
+
+/**
+ * @brief Drop a message reference
+ * 
+ * The last reference frees any dynamic payload and hands the
+ * MsgData slot back to the scheduler's message pool.
+ */
+void SharedMsg::release() {
+  if (data) {
+    bool should_delete = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      data->ref_count--;
+      should_delete = (data->ref_count == 0);
+    }
+    if (should_delete) {
+      if (data->is_dynamic && data->ptr) {
+        delete[] static_cast<uint8_t*>(data->ptr);
+      }
+      OS.msg_pool.free(data);
+    }
+    data = nullptr;
+  }
+}
 
 /* ================== Scheduler Implementation ================== */
 
@@ -50,13 +270,58 @@ void Scheduler::begin() {
   // For non-AVR, we can't determine reset cause this way.
   reset_info.reset_reason = 0;
 #endif
+  // last_task_id still names the task that ran before the reset. Keep it
+  // for get_reset_info() and clear the live one, which also picks the task
+  // heap allocations are charged to, before setup() allocates anything.
+  reset_task_id = reset_info.last_task_id;
+  reset_info.last_task_id = FSMOS_NO_TASK;
+#if FSMOS_TRACE_SIZE
+  init_trace(reset_info.reset_reason);
+#else
+  reset_info.trace_count = 0;
+#endif
 
   // Initialize the linked list
   task_list = nullptr;
   task_count = 0;
-  next_task_id = 0;
+  memset(task_slots, 0, sizeof(task_slots));
+  memset(slot_generation, 0, sizeof(slot_generation));
   ms = millis();
   watchdog_enabled = false;
+  topic_index_dirty = true;
+  reap_pending = false;
+  run_queue_len = 0;
+  ready_len = 0;
+  dispatch_seq = 0;
+  memset(topic_coalesce, 0, sizeof(topic_coalesce));
+  bus_merged = 0;
+  bus_deferred = 0;
+  bus_discarded = 0;
+#if FSMOS_TOPIC_STATS
+  reset_topic_stats();
+#endif
+#if FSMOS_LOG_BUFFER_SIZE
+  log_tail = 0;
+  log_used = 0;
+  log_high_water = 0;
+  log_line_pos = 0;
+  log_gap = false;
+  log_dropped = 0;
+  log_truncated = 0;
+  log_direct = true;
+#endif
+  isr_sources = nullptr;
+  mailbox_pending = false;
+  delivery_budget_msgs = FSMOS_DELIVERY_BUDGET_MSGS;
+  delivery_budget_us = FSMOS_DELIVERY_BUDGET_US;
+  timer_count = 0;
+  policy = FSMOS_SCHED_POLICY;
+#if FSMOS_STACK_MONITOR && defined(__AVR__)
+  // Painted at boot (or by an earlier enable_stack_monitoring())
+  stack_paint_floor = heap_end();
+  stack_low_water = SP;
+#endif
+  reset_idle_stats();
 }
 
 // Optional: initialize with logger (alias to begin for now)
@@ -64,38 +329,239 @@ void Scheduler::begin_with_logger() {
   begin();
 }
 
-void Scheduler::_print_log_prefix(Task* task, LogLevel level) {
+void Scheduler::_print_log_prefix(Print& out, Task* task, LogLevel level, uint32_t t) const {
 #ifndef FSMOS_DISABLE_LOGGING
   static const char PROGMEM levelChars[] = {'D', 'I', 'W', 'E'};
   
-  uint32_t t = now();
-  Serial.print('[');
-  Serial.print(t / 1000);
-  Serial.print(':');
-  Serial.print(t % 1000);
-  Serial.print(F("]["));
-  Serial.write(pgm_read_byte(&levelChars[level]));
-  Serial.print(F("]["));
+  out.print('[');
+  out.print(t / 1000);
+  out.print(':');
+  out.print(t % 1000);
+  out.print(F("]["));
+  out.write(pgm_read_byte(&levelChars[level]));
+  out.print(F("]["));
   if (task && task->get_name()) {
-    Serial.print(task->get_name());
+    out.print(task->get_name());
   } else {
-    Serial.write('-');
+    out.write('-');
   }
-  Serial.print(']');
-  Serial.print(' ');
+  out.print(']');
+  out.print(' ');
 #endif
 }
 
+#if FSMOS_LOG_BUFFER_SIZE
+/* ================== Log Buffer ================== */
+// Record header: text length, level and flags, task ID, now() (4 bytes)
+static const uint8_t LOG_HEADER_SIZE = 7;
+static const uint8_t LOG_REC_FLASH = 0x80;  // Payload is the address of a flash string
+static const uint8_t LOG_REC_GAP = 0x40;    // Lines were dropped just before this one
+static const uint8_t LOG_REC_TRUNC = 0x20;  // Text was cut short to fit the buffer
+static const uint8_t LOG_REC_LEVEL = 0x03;
+
+/**
+ * @brief Print that passes characters on to Serial while the UART has room
+ * 
+ * A record is rendered again until it has been written completely; the
+ * characters an earlier attempt already wrote are skipped.
+ */
+class LogWriter : public Print {
+public:
+  LogWriter(uint8_t skip, uint8_t room) : written(0), full(false), skip(skip), room(room) {}
+
+  size_t write(uint8_t c) override {
+    if (skip) {
+      skip--;
+      return 1;
+    }
+    if (!room) {
+      full = true;
+      return 0;
+    }
+    Serial.write(c);
+    room--;
+    written++;
+    return 1;
+  }
+
+  uint8_t written;
+  bool full;
+
+private:
+  uint8_t skip;
+  uint8_t room;
+};
+
+/**
+ * @brief Copy a log line into the buffer, or count it as dropped
+ * @param flags Level and LOG_REC_FLASH
+ * @param payload Text (not terminated) or flash string address
+ * @param len Bytes of payload; text too long for the buffer is cut short
+ *            and marked
+ */
+void Scheduler::queue_log(Task* task, uint8_t flags, const void* payload, uint8_t len) {
+  if (len > FSMOS_LOG_BUFFER_SIZE - LOG_HEADER_SIZE) {
+    len = FSMOS_LOG_BUFFER_SIZE - LOG_HEADER_SIZE;
+    flags |= LOG_REC_TRUNC;
+    if (log_truncated != 0xFFFF) log_truncated++;
+  }
+  uint8_t size = LOG_HEADER_SIZE + len;
+  // Hand what the UART's own buffer can take to it first; never waits
+  if (size > FSMOS_LOG_BUFFER_SIZE - log_used) drain_log();
+  if (size > FSMOS_LOG_BUFFER_SIZE - log_used) {
+    if (log_dropped != 0xFFFF) log_dropped++;
+    log_gap = true;
+    return;
+  }
+
+  uint32_t t = now();
+  uint8_t header[LOG_HEADER_SIZE] = {
+    len, (uint8_t)(flags | (log_gap ? LOG_REC_GAP : 0)), task ? task->get_id() : FSMOS_NO_TASK,
+    (uint8_t)t, (uint8_t)(t >> 8), (uint8_t)(t >> 16), (uint8_t)(t >> 24)
+  };
+  uint8_t pos = log_tail + log_used;
+  for (uint8_t i = 0; i < size; i++) {
+    uint8_t b = i < LOG_HEADER_SIZE ? header[i] : ((const uint8_t*)payload)[i - LOG_HEADER_SIZE];
+    log_buf[pos++ & (FSMOS_LOG_BUFFER_SIZE - 1)] = b;
+  }
+  log_used += size;
+  if (log_used > log_high_water) log_high_water = log_used;
+  log_gap = false;
+}
+
+/**
+ * @brief Render the oldest buffered record as a log line
+ */
+void Scheduler::print_log_record(Print& out) const {
+  uint8_t len = log_byte(0);
+  uint8_t flags = log_byte(1);
+  uint32_t t = 0;
+  for (uint8_t i = 0; i < 4; i++) t |= (uint32_t)log_byte(3 + i) << (8 * i);
+
+  // Tasks are looked up by ID, so one removed meanwhile shows as '-'
+  TaskNode* node = find_task_node(log_byte(2));
+  if (flags & LOG_REC_GAP) out.write('~');
+  _print_log_prefix(out, node ? node->task : nullptr, (LogLevel)(flags & LOG_REC_LEVEL), t);
+  if (flags & LOG_REC_FLASH) {
+    const __FlashStringHelper* msg;
+    uint8_t* dst = (uint8_t*)&msg;
+    for (uint8_t i = 0; i < sizeof(msg); i++) dst[i] = log_byte(LOG_HEADER_SIZE + i);
+    out.print(msg);
+  } else {
+    for (uint8_t i = 0; i < len; i++) out.write(log_byte(LOG_HEADER_SIZE + i));
+    if (flags & LOG_REC_TRUNC) out.write('~');
+  }
+  out.println();
+}
+
+void Scheduler::pop_log_record() {
+  uint8_t size = LOG_HEADER_SIZE + log_byte(0);
+  log_tail = (log_tail + size) & (FSMOS_LOG_BUFFER_SIZE - 1);
+  log_used -= size;
+  log_line_pos = 0;
+}
+
+/**
+ * @brief Write buffered log lines for as long as the UART has room
+ * 
+ * Called by loop_once() once tasks and messages are done, so logging
+ * never makes step() or on_msg() wait for Serial.
+ */
+void Scheduler::drain_log() {
+  while (log_used) {
+    int room = Serial.availableForWrite();
+    if (room <= 0) return;
+    LogWriter out(log_line_pos, room > 255 ? 255 : room);
+    print_log_record(out);
+    if (out.full) {
+      log_line_pos += out.written;
+      return;
+    }
+    pop_log_record();
+  }
+}
+
+/**
+ * @brief Write every buffered record, waiting for the UART as needed
+ */
+void Scheduler::write_log_backlog() {
+  while (log_used) {
+    // Serial.write() waits for the UART, even with interrupts disabled
+    LogWriter out(log_line_pos, 255);
+    print_log_record(out);
+    pop_log_record();
+  }
+}
+#endif
+
+void Scheduler::flush_log() {
+#if FSMOS_LOG_BUFFER_SIZE
+  write_log_backlog();
+  Serial.flush();
+#endif
+}
+
+void Scheduler::get_log_stats(LogStats& stats) const {
+#if FSMOS_LOG_BUFFER_SIZE
+  stats.pending = log_used;
+  stats.high_water = log_high_water;
+  stats.dropped = log_dropped;
+  stats.truncated = log_truncated;
+#else
+  stats.pending = 0;
+  stats.high_water = 0;
+  stats.dropped = 0;
+  stats.truncated = 0;
+#endif
+}
+
+/**
+ * @brief Apply the level filters to a direct call, as the Task helpers do
+ * @param task Logging task, or nullptr for messages outside any task
+ */
+bool Scheduler::log_wanted(Task* task, LogLevel level) const {
+  if (task) return task->log_enabled(level);
+  return level >= FSMOS_LOG_LEVEL && level <= LOG_ERROR;
+}
+
+/**
+ * @brief Log a message from flash
+ * 
+ * With FSMOS_LOG_BUFFER_SIZE the line is queued for drain_log() and
+ * this returns at once. LOG_ERROR lines flush the buffer and are written
+ * straight away, so they are not lost if a fault follows; so are lines
+ * logged outside loop_once(), where nothing would drain the buffer.
+ */
 void Scheduler::logMessage(Task* task, LogLevel level, const __FlashStringHelper* msg) {
+  if (!log_wanted(task, level)) return;
+  uint16_t addr = (uint16_t)(uintptr_t)msg;
+  trace(TRACE_LOG, addr & 0xFF, addr >> 8);
 #ifndef FSMOS_DISABLE_LOGGING
-  _print_log_prefix(task, level);
+#if FSMOS_LOG_BUFFER_SIZE
+  if (level < LOG_ERROR && !log_direct) {
+    queue_log(task, level | LOG_REC_FLASH, &msg, sizeof(msg));
+    return;
+  }
+  // Errors, and lines logged outside loop_once() (e.g. from setup()),
+  // go out at once after everything queued before them
+  write_log_backlog();
+#endif
+  _print_log_prefix(Serial, task, level, now());
   Serial.println(msg);
 #endif
 }
 
+/**
+ * @brief Log a printf-style message with a format string in flash
+ * 
+ * The text is formatted here (at most 63 characters); buffering works as
+ * for logMessage().
+ */
 void Scheduler::logFormatted(Task* task, LogLevel level, const __FlashStringHelper* fmt, ...) {
+  if (!log_wanted(task, level)) return;
+  uint16_t addr = (uint16_t)(uintptr_t)fmt;
+  trace(TRACE_LOG, addr & 0xFF, addr >> 8);
 #ifndef FSMOS_DISABLE_LOGGING
-  _print_log_prefix(task, level);
   char fmt_buf[64];
   uint8_t i = 0;
   const char* p = reinterpret_cast<const char*>(fmt);
@@ -111,6 +577,14 @@ void Scheduler::logFormatted(Task* task, LogLevel level, const __FlashStringHelp
   va_start(args, fmt);
   vsnprintf(out_buf, sizeof(out_buf), fmt_buf, args);
   va_end(args);
+#if FSMOS_LOG_BUFFER_SIZE
+  if (level < LOG_ERROR && !log_direct) {
+    queue_log(task, level, out_buf, strlen(out_buf));
+    return;
+  }
+  write_log_backlog();
+#endif
+  _print_log_prefix(Serial, task, level, now());
   Serial.println(out_buf);
 #endif
 }
@@ -119,23 +593,58 @@ void Scheduler::logFormatted(Task* task, LogLevel level, const __FlashStringHelp
 /**
  * @brief Add a new task to the scheduler
  * 
+ * The scheduler owns the task and deletes it after it terminates.
+ * 
+ * @param t Pointer to the task to add
+ * @return Assigned task ID (FSMOS_NO_TASK if failed)
+ */
+uint8_t Scheduler::add(Task* t) {
+  return register_task(t, true);
+}
+
+/**
+ * @brief Add a statically allocated task to the scheduler
+ * 
+ * @param t Task that outlives the scheduler (e.g. a global)
+ * @return Assigned task ID (FSMOS_NO_TASK if failed)
+ */
+uint8_t Scheduler::add_static(Task& t) {
+  return register_task(&t, false);
+}
+
+/**
+ * @brief Register a task with the scheduler
+ * 
  * This method:
  * - Assigns a unique ID to the task
- * - Creates a new task node
+ * - Initializes the task's embedded node
  * - Initializes task state
  * - Links task into task list
  * - Calls task's start handler
  * 
- * @param t Pointer to the task to add
- * @return Assigned task ID (255 if failed)
+ * @param t Task to register
+ * @param owned Whether the scheduler deletes the task when it terminates
+ * @return Assigned task ID (FSMOS_NO_TASK if failed)
  */
-uint8_t Scheduler::add(Task* t) {
-  uint8_t new_id = next_task_id++;
-  if (next_task_id == 0) {  // Wrapped around
-    next_task_id = 1;  // Skip 0 for next time
+uint8_t Scheduler::register_task(Task* t, bool owned) {
+  if (task_count >= FSMOS_MAX_TASKS || t->node.task) return FSMOS_NO_TASK;
+
+  uint8_t slot = 0;
+  while (task_slots[slot]) slot++;  // task_count < FSMOS_MAX_TASKS, so one is free
+
+  // Skip the generation that would produce FSMOS_NO_TASK
+  uint8_t new_id = (uint8_t)(slot_generation[slot] << FSMOS_TASK_SLOT_BITS) | slot;
+  if (new_id == FSMOS_NO_TASK) {
+    slot_generation[slot]++;
+    new_id = (uint8_t)(slot_generation[slot] << FSMOS_TASK_SLOT_BITS) | slot;
   }
 
-  TaskNode* new_node = new TaskNode(t, new_id);
+  TaskNode* new_node = &t->node;
+  *new_node = TaskNode();
+  new_node->task = t;
+  new_node->id = new_id;
+  new_node->owned = owned;
+  task_slots[slot] = new_node;
   t->id = new_id;
   t->state = Task::ACTIVE;
   t->next_due = ms; // Run as soon as possible
@@ -144,6 +653,8 @@ uint8_t Scheduler::add(Task* t) {
   new_node->next = task_list;
   task_list = new_node;
   task_count++;
+  topic_index_dirty = true;
+  if (t->period_ms) heap_insert(new_node);
   
   t->on_start();
   return new_id;
@@ -157,7 +668,14 @@ bool Scheduler::remove(uint8_t task_id) {
     if ((*curr)->id == task_id) {
       TaskNode* to_delete = *curr;
       *curr = to_delete->next;
-      delete to_delete;
+      heap_remove(to_delete);
+      unindex_task(to_delete);
+      release_slot(to_delete);
+      // May be called from a step() while loop_once() holds the ready list
+      for (uint8_t i = 0; i < ready_len; i++) {
+        if (ready[i] == to_delete) ready[i] = nullptr;
+      }
+      to_delete->task = nullptr;  // Node lives in the Task; mark it unregistered
       task_count--;
       return true;
     }
@@ -166,8 +684,81 @@ bool Scheduler::remove(uint8_t task_id) {
   return false;
 }
 
-bool Scheduler::post(uint8_t type, uint8_t src_id, uint8_t topic, uint16_t arg, void* ptr, bool is_dynamic) {
-  MsgData* data = new MsgData();
+bool Scheduler::post(uint8_t type, uint8_t src_id, uint8_t topic, uint16_t arg, void* ptr, bool is_dynamic,
+                     const void* payload, uint8_t payload_size) {
+#if FSMOS_MSG_INLINE_SIZE > 0
+  if (payload_size > FSMOS_MSG_INLINE_SIZE) return false;
+#else
+  if (payload_size) return false;
+#endif
+
+  // Fold into a pending message if the topic's policy allows
+  if (topic != 0 && coalesce(type, src_id, topic, arg, ptr, is_dynamic, payload, payload_size)) {
+#if FSMOS_TOPIC_STATS
+    if (topic < FSMOS_MAX_TOPICS && topic_stats[topic].posted != 0xFFFF) topic_stats[topic].posted++;
+#endif
+    return true;
+  }
+
+  MsgData* data = make_msg(type, src_id, topic, arg, ptr, is_dynamic, payload, payload_size);
+  if (!data) {
+    count_dropped(topic);  // Pool exhausted, also counted in MsgPoolStats
+    return false;
+  }
+  
+  // ref_count tracks live SharedMsg handles only; the queue entry holds the first one
+  if (!has_targets(data)) {
+    msg_pool.free(data);
+    count_dropped(topic);
+    return false;
+  }
+  
+  return enqueue(SharedMsg(data));
+}
+
+/**
+ * @brief Queue a message on the bus, stamping it for topic statistics
+ * @return false if the bus is full (counted in BusStats::dropped)
+ */
+bool Scheduler::enqueue(const SharedMsg& msg) {
+  if (msg->topic) {
+    trace(TRACE_MSG_POST, msg->type, msg->topic);
+  } else {
+    trace(TRACE_MSG_TELL, msg->type, msg->src_id);
+  }
+#if FSMOS_TOPIC_STATS
+  uint8_t topic = msg->topic;
+  msg.get()->post_us = micros();
+  if (!message_queue.push(msg)) {
+    count_dropped(topic);
+    return false;
+  }
+  if (topic < FSMOS_MAX_TOPICS && topic_stats[topic].posted != 0xFFFF) topic_stats[topic].posted++;
+  return true;
+#else
+  return message_queue.push(msg);
+#endif
+}
+
+/**
+ * @brief Count a post that never reached the bus against its topic
+ */
+void Scheduler::count_dropped(uint8_t topic) {
+#if FSMOS_TOPIC_STATS
+  if (topic < FSMOS_MAX_TOPICS && topic_stats[topic].dropped != 0xFFFF) topic_stats[topic].dropped++;
+#else
+  (void)topic;
+#endif
+}
+
+/**
+ * @brief Allocate a message from the pool and fill it in
+ * @return The message, or nullptr if the pool is exhausted
+ */
+MsgData* Scheduler::make_msg(uint8_t type, uint8_t src_id, uint8_t topic, uint16_t arg, void* ptr, bool is_dynamic,
+                             const void* payload, uint8_t payload_size) {
+  MsgData* data = msg_pool.alloc();
+  if (!data) return nullptr;
   data->type = type;
   data->src_id = src_id;
   data->topic = topic;
@@ -175,146 +766,828 @@ bool Scheduler::post(uint8_t type, uint8_t src_id, uint8_t topic, uint16_t arg,
   data->ptr = ptr;
   data->is_dynamic = is_dynamic;
   data->dynamic_size = 0;  // Will be set by the caller if needed
-  
-  // Count subscribers
-  uint8_t target_count = 0;
-  if (topic == 0) {
+  data->count = 1;
+#if FSMOS_MSG_INLINE_SIZE > 0
+  if (payload_size) memcpy(data->payload, payload, payload_size);
+#else
+  (void)payload;
+  (void)payload_size;
+#endif
+  return data;
+}
+
+/**
+ * @brief Check whether a message currently has anyone to deliver to
+ * @param data Direct message (src_id holds the destination) or topic message
+ */
+bool Scheduler::has_targets(const MsgData* data) const {
+  if (data->topic == 0) {
     // Direct message
-    TaskNode* target_node = find_task_node(src_id);
-    if (target_node && target_node->task) target_count = 1;
-  } else {
-    // Topic-based message
-    TaskNode* curr = task_list;
-    while (curr) {
-      if (curr->task && curr->task->is_subscribed_to(topic)) target_count++;
-      curr = curr->next;
+    TaskNode* target_node = find_task_node(data->src_id);
+    return target_node && target_node->task;
+  }
+  // Topic-based message
+  return count_subscribers(data->topic) > 0;
+}
+
+/**
+ * @brief Post a message that is delivered at an absolute time
+ * 
+ * The message is built now (taking a pool slot) and held in a
+ * time-ordered timer table until loop_once() reaches its due time;
+ * then it is queued on the bus like a normal post(). Subscribers are
+ * looked up when it fires, and coalescing does not apply.
+ * 
+ * @param when Absolute time in milliseconds (see now())
+ * @return Handle for cancel_timer(), or TIMER_NONE if the timer table
+ *         or message pool is full
+ */
+TimerHandle Scheduler::post_at(uint32_t when, uint8_t type, uint8_t src_id, uint8_t topic, uint16_t arg,
+                               void* ptr, bool is_dynamic, const void* payload, uint8_t payload_size) {
+#if FSMOS_MSG_INLINE_SIZE > 0
+  if (payload_size > FSMOS_MSG_INLINE_SIZE) return TIMER_NONE;
+#else
+  if (payload_size) return TIMER_NONE;
+#endif
+  if (timer_count >= FSMOS_MAX_TIMERS) return TIMER_NONE;
+
+  MsgData* data = make_msg(type, src_id, topic, arg, ptr, is_dynamic, payload, payload_size);
+  if (!data) return TIMER_NONE;
+
+  uint8_t slot = 0;
+  while (timer_msgs[slot].valid()) slot++;  // timer_count < FSMOS_MAX_TIMERS, so one is free
+  timer_msgs[slot] = SharedMsg(data);
+  timer_due[slot] = when;
+  timer_generation[slot]++;
+
+  // Insert into the due-ordered index, after timers with the same due time
+  uint8_t pos = timer_count;
+  while (pos > 0 && (int32_t)(when - timer_due[timer_order[pos - 1]]) < 0) {
+    timer_order[pos] = timer_order[pos - 1];
+    pos--;
+  }
+  timer_order[pos] = slot;
+  timer_count++;
+
+  return ((TimerHandle)timer_generation[slot] << 8) | (slot + 1);
+}
+
+/**
+ * @brief Cancel a message posted with post_at()/post_after()
+ * 
+ * The message is released, including its dynamic ptr. Handles of timers
+ * that already fired or were cancelled are ignored.
+ * 
+ * @param handle Handle returned when the timer was set
+ * @return true if a pending timer was cancelled
+ */
+bool Scheduler::cancel_timer(TimerHandle handle) {
+  uint8_t slot = (uint8_t)(handle & 0xFF) - 1;
+  if (slot >= FSMOS_MAX_TIMERS || !timer_msgs[slot].valid() ||
+      timer_generation[slot] != (uint8_t)(handle >> 8)) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < timer_count; i++) {
+    if (timer_order[i] == slot) {
+      timer_count--;
+      memmove(&timer_order[i], &timer_order[i + 1], timer_count - i);
+      break;
+    }
+  }
+  timer_msgs[slot].release();
+  return true;
+}
+
+/**
+ * @brief Move timers that are due onto the message bus
+ * @param now Current time in milliseconds
+ */
+void Scheduler::fire_timers(uint32_t now) {
+  while (timer_count && (int32_t)(now - timer_due[timer_order[0]]) >= 0) {
+    uint8_t slot = timer_order[0];
+    timer_count--;
+    memmove(&timer_order[0], &timer_order[1], timer_count);
+
+    SharedMsg msg = timer_msgs[slot];
+    timer_msgs[slot].release();
+    if (has_targets(msg.get())) {
+      enqueue(msg);  // A full bus counts the drop in BusStats
+    } else {
+      count_dropped(msg->topic);
+    }
+  }
+}
+
+/**
+ * @brief Merge a topic message into one already waiting on the bus
+ * 
+ * Uses the topic's CoalescePolicy. The pending message keeps its place
+ * in the queue; no pool slot is taken for the new one.
+ * 
+ * @return true if the message was merged and must not be queued
+ */
+bool Scheduler::coalesce(uint8_t type, uint8_t src_id, uint8_t topic, uint16_t arg, void* ptr, bool is_dynamic,
+                         const void* payload, uint8_t payload_size) {
+  CoalescePolicy policy = get_coalesce_policy(topic);
+  if (policy == COALESCE_NONE) return false;
+
+#if FSMOS_MSG_INLINE_SIZE > 0
+  // Compare against the payload the new message would carry
+  uint8_t new_payload[FSMOS_MSG_INLINE_SIZE] = {0};
+  if (payload_size) memcpy(new_payload, payload, payload_size);
+#else
+  (void)payload;
+  (void)payload_size;
+#endif
+
+  // Only the newest pending message on the topic can absorb the post.
+  // Merging into an older one would move the post ahead of messages
+  // published after it: A, B, A must not arrive as A, B.
+  SharedMsg* pending = message_queue.find_last([&](const SharedMsg& m) { return m->topic == topic; });
+  if (!pending) return false;
+
+  MsgData* data = pending->get();
+  if (policy != COALESCE_LATEST) {
+    if (data->type != type) return false;
+    if (policy == COALESCE_DROP_IDENTICAL) {
+#if FSMOS_MSG_INLINE_SIZE > 0
+      if (memcmp(data->payload, new_payload, FSMOS_MSG_INLINE_SIZE) != 0) return false;
+#endif
+      if (data->arg != arg || data->ptr != ptr) return false;
+    }
+  }
+
+  if (policy == COALESCE_LATEST) {
+    // Not delivered yet, so nothing else references the payload
+    if (data->is_dynamic && data->ptr && data->ptr != ptr) {
+      delete[] static_cast<uint8_t*>(data->ptr);
+    }
+    data->type = type;
+    data->src_id = src_id;
+    data->arg = arg;
+    data->ptr = ptr;
+    data->is_dynamic = is_dynamic;
+    data->dynamic_size = 0;
+#if FSMOS_MSG_INLINE_SIZE > 0
+    memcpy(data->payload, new_payload, FSMOS_MSG_INLINE_SIZE);
+#endif
+  } else if (policy == COALESCE_COUNT) {
+    if (data->count < 0xFF) data->count++;
+    if (is_dynamic && ptr && ptr != data->ptr) delete[] static_cast<uint8_t*>(ptr);
+  }
+  // COALESCE_DROP_IDENTICAL: same ptr as the pending message, nothing to free
+
+  if (bus_merged < 0xFFFF) bus_merged++;
+  return true;
+}
+
+bool Scheduler::set_coalesce_policy(uint8_t topic, CoalescePolicy policy) {
+  if (topic == 0 || (uint16_t)topic >= FSMOS_MAX_TOPICS) return false;
+  uint8_t shift = (topic & 3) * 2;
+  topic_coalesce[topic >> 2] = (topic_coalesce[topic >> 2] & ~(3 << shift)) | ((policy & 3) << shift);
+  return true;
+}
+
+CoalescePolicy Scheduler::get_coalesce_policy(uint8_t topic) const {
+  if (topic == 0 || (uint16_t)topic >= FSMOS_MAX_TOPICS) return COALESCE_NONE;
+  return static_cast<CoalescePolicy>((topic_coalesce[topic >> 2] >> ((topic & 3) * 2)) & 3);
+}
+
+/**
+ * @brief Execute one iteration of the scheduler
+ * 
+ * This is the core scheduling loop that:
+ * 1. Updates system time
+ * 2. Delivers pending messages
+ * 3. Handles task cleanup
+ * 4. Executes due tasks from the run queue
+ * 5. Updates task statistics
+ * 6. Manages watchdog
+ * 7. Writes buffered log lines while the UART has room
+ * 8. Idles until the next task or message is due
+ * 
+ * The scheduler ensures:
+ * - Tasks run in their configured periods
+ * - Messages are delivered promptly
+ * - Resources are cleaned up
+ * - Only tasks that are actually due are touched
+ */
+void Scheduler::loop_once() {
+  // 1. Update time
+  uint32_t now = millis();
+  ms = now;
+#if FSMOS_LOG_BUFFER_SIZE
+  log_direct = false;
+#endif
+
+  // 2. Move events posted from interrupts and delayed messages that are
+  // due onto the bus, then deliver, within the delivery budget
+  drain_isr_sources();
+  fire_timers(now);
+  deliver();
+
+  // 3. Delete tasks terminated since the last iteration
+  if (reap_pending) {
+    reap_terminated();
+  }
+
+  // 4. Take every due task off the run queue, then order them by policy.
+  // Each task runs at most once per iteration, even if its period lets
+  // it fall due again.
+  ready_len = 0;
+  while (run_queue_len && (int32_t)(now - run_queue[0]->task->next_due) >= 0) {
+    TaskNode* node = run_queue[0];
+    heap_remove(node);
+    ready[ready_len++] = node;
+  }
+  sort_ready();
+
+  for (uint8_t i = 0; i < ready_len; i++) {
+    TaskNode* node = ready[i];
+    // An earlier step() may have removed, suspended or terminated this task
+    if (!node || !node->task->is_active()) continue;
+    Task* task = node->task;
+
+    node->last_dispatch = ++dispatch_seq;
+    run_task(node);
+
+    // step() may have suspended or terminated the task, or another call
+    // (e.g. activate()) may already have queued it again
+    if (!task->is_active() || node->heap_pos != TaskNode::NOT_QUEUED) continue;
+
+    // Event-driven tasks only run again when woken by a message
+    if (task->get_period() == 0) continue;
+
+    // Schedule next run
+    task->next_due += task->get_period();
+    
+    // Handle missed deadlines
+    if ((int32_t)(task->next_due - now) < 0) {
+      task->next_due = now + task->get_period();
+      if (node->stats.missed_deadlines != 0xFFFF) node->stats.missed_deadlines++;
     }
+    heap_insert(node);
   }
+  ready_len = 0;
   
-  data->ref_count = target_count;
-  if (target_count == 0) {
-    delete data;
-    return false;
+  // 5. Pet the watchdog
+  if (watchdog_enabled) {
+    wdt_reset();
+  }
+
+  // 6. Logging has the lowest priority: it gets the UART once tasks and
+  // messages are done. The TX interrupt wakes idle() to write more.
+#if FSMOS_LOG_BUFFER_SIZE
+  log_direct = true;
+  drain_log();
+#endif
+
+  // 7. Nothing left to do until next_wakeup()
+#if FSMOS_IDLE_SLEEP
+  idle();
+#endif
+}
+
+/**
+ * @brief Idle the CPU until the next task or message is due
+ * 
+ * With no hook installed, AVR builds sleep in SLEEP_MODE_IDLE. Timers,
+ * pin-change and UART interrupts keep running and wake the CPU, and
+ * timer0 ticks every ~1 ms, so a due task is never delayed by more than
+ * one tick. Time spent here is accumulated for get_idle_stats().
+ */
+void Scheduler::idle() {
+  int32_t wait = (int32_t)(next_wakeup() - millis());
+  if (wait <= 0) return;
+
+  uint32_t start_us = micros();
+  if (idle_hook) {
+    idle_hook((uint32_t)wait);
+  } else {
+#if defined(__AVR__)
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+#else
+    return;
+#endif
+  }
+
+  uint32_t slept_us = (micros() - start_us) + idle_us_rem;
+  idle_ms += slept_us / 1000;
+  idle_us_rem = slept_us % 1000;
+}
+
+void Scheduler::get_idle_stats(IdleStats& stats) const {
+  stats.idle_ms = idle_ms;
+  stats.window_ms = millis() - idle_window_start;
+  // Divide by window/100 rather than multiplying idle_ms, which would overflow
+  uint32_t pct = stats.window_ms >= 100 ? idle_ms / (stats.window_ms / 100) : 0;
+  stats.idle_percent = pct > 100 ? 100 : (uint8_t)pct;
+}
+
+void Scheduler::reset_idle_stats() {
+  idle_ms = 0;
+  idle_us_rem = 0;
+  idle_window_start = millis();
+}
+
+/**
+ * @brief Check whether a ready task should run before another
+ * 
+ * - SCHED_EDF: earlier next_due first
+ * - SCHED_FIXED_PRIORITY: higher priority first, then earlier next_due
+ * - SCHED_ROUND_ROBIN: least recently dispatched first
+ */
+bool Scheduler::runs_before(const TaskNode* a, const TaskNode* b) const {
+  switch (policy) {
+    case SCHED_FIXED_PRIORITY:
+      if (a->task->priority != b->task->priority) {
+        return a->task->priority > b->task->priority;
+      }
+      break;
+    case SCHED_ROUND_ROBIN:
+      if (a->last_dispatch != b->last_dispatch) {
+        return (int16_t)(a->last_dispatch - b->last_dispatch) < 0;
+      }
+      break;
+    default:
+      break;
+  }
+  return due_before(a, b);
+}
+
+/**
+ * @brief Order the ready list by the scheduling policy
+ * 
+ * Insertion sort: at most FSMOS_MAX_TASKS entries, and the list comes off
+ * the heap already in next_due order, so EDF needs no moves.
+ */
+void Scheduler::sort_ready() {
+  for (uint8_t i = 1; i < ready_len; i++) {
+    TaskNode* node = ready[i];
+    uint8_t j = i;
+    while (j > 0 && runs_before(node, ready[j - 1])) {
+      ready[j] = ready[j - 1];
+      j--;
+    }
+    ready[j] = node;
+  }
+}
+
+/**
+ * @brief Run one step() of a task with profiling
+ * @param node Node of the task to run
+ */
+void Scheduler::run_task(TaskNode* node) {
+  TaskStats& stats = node->stats;
+
+  // WDT & Profiling Start. Lateness is measured here rather than against
+  // the iteration's start time, so tasks sorted behind slow ones show it.
+  reset_info.last_task_id = node->id;
+  int32_t late = (int32_t)(millis() - node->task->next_due);
+  trace(TRACE_TASK_START, node->id, 0);
+#if FSMOS_STACK_MONITOR && defined(__AVR__)
+  uint16_t sp_before = begin_stack_probe();
+#endif
+  uint32_t start_us = micros();
+
+  node->task->step();
+
+  // Profiling End
+  uint32_t exec_time = micros() - start_us;
+  trace(TRACE_TASK_END, node->id, 0);
+#if FSMOS_STACK_MONITOR && defined(__AVR__)
+  probe_stack(node, sp_before);
+#endif
+  uint16_t late_ms = late <= 0 ? 0 : late > 0xFFFF ? 0xFFFF : (uint16_t)late;
+
+  if (stats.total_exec_time_us > 0xFFFFFFFFUL - exec_time) {
+    stats.total_exec_time_us = 0xFFFFFFFFUL;
+  } else {
+    stats.total_exec_time_us += exec_time;
+  }
+  if (exec_time > stats.max_exec_time_us) {
+    stats.max_exec_time_us = exec_time;
+  }
+  if (late_ms > stats.max_lateness_ms) {
+    stats.max_lateness_ms = late_ms;
+  }
+  if (stats.run_count != 0xFFFFFFFFUL) stats.run_count++;
+
+#if FSMOS_STATS_BUCKETS > 0
+  uint8_t bucket = stats_bucket(exec_time, EXEC_HIST_SHIFT);
+  if (stats.exec_hist[bucket] != 0xFFFF) stats.exec_hist[bucket]++;
+  bucket = stats_bucket(late_ms, LATE_HIST_SHIFT);
+  if (stats.late_hist[bucket] != 0xFFFF) stats.late_hist[bucket]++;
+#endif
+}
+
+uint8_t Scheduler::stats_bucket(uint32_t value, uint8_t shift) {
+  // Every two bits of magnitude is one bucket: ceil(bit_length / 2)
+  value >>= shift;
+  uint8_t bucket = 0;
+  while (value && bucket < FSMOS_STATS_BUCKETS - 1) {
+    value >>= 2;
+    bucket++;
+  }
+  return bucket;
+}
+
+/**
+ * @brief Make a task due now after a message was delivered to it
+ * 
+ * Several messages delivered in one iteration still produce a single
+ * step(), which runs in the same loop_once() right after delivery.
+ * 
+ * @param node Node of the task that received the message
+ */
+void Scheduler::wake_task(TaskNode* node) {
+  Task* task = node->task;
+  if (!task->is_active() || !task->get_wake_on_msg()) return;
+  task->next_due = ms;
+  if (node->heap_pos == TaskNode::NOT_QUEUED) {
+    heap_insert(node);
+  } else {
+    heap_sift_up(node->heap_pos);
+  }
+}
+
+/**
+ * @brief Delete tasks that called terminate()
+ * 
+ * Only walks the task list when a termination is pending.
+ */
+void Scheduler::reap_terminated() {
+  reap_pending = false;
+  TaskNode** curr = &task_list;
+  while (*curr) {
+    TaskNode* node = *curr;
+    Task* task = node->task;
+    if (task && task->is_inactive()) {
+      // Unlink the task, then delete it if the scheduler owns it
+      *curr = node->next;
+      heap_remove(node);
+      unindex_task(node);
+      release_slot(node);
+      node->task = nullptr;
+      task_count--;
+      if (node->owned) {
+        delete task;       // This will call on_terminate()
+      } else {
+        task->on_terminate();
+      }
+    } else {
+      curr = &(node->next);
+    }
+  }
+}
+
+uint32_t Scheduler::next_wakeup() const {
+  if (!message_queue.empty() || mailbox_pending) return ms;
+  for (IsrSource* src = isr_sources; src; src = src->next) {
+    if (!src->empty()) return ms;
+  }
+  uint32_t wake = ms + INT32_MAX;
+  if (run_queue_len) wake = run_queue[0]->task->next_due;
+  if (timer_count && (int32_t)(timer_due[timer_order[0]] - wake) < 0) {
+    wake = timer_due[timer_order[0]];
+  }
+  return wake;
+}
+
+/* ================== Run Queue ================== */
+
+// Wrap-safe ordering of two nodes by next_due
+bool Scheduler::due_before(const TaskNode* a, const TaskNode* b) {
+  return (int32_t)(a->task->next_due - b->task->next_due) < 0;
+}
+
+void Scheduler::heap_place(uint8_t pos, TaskNode* node) {
+  run_queue[pos] = node;
+  node->heap_pos = pos;
+}
+
+void Scheduler::heap_sift_up(uint8_t pos) {
+  TaskNode* node = run_queue[pos];
+  while (pos > 0) {
+    uint8_t parent = (pos - 1) / 2;
+    if (!due_before(node, run_queue[parent])) break;
+    heap_place(pos, run_queue[parent]);
+    pos = parent;
+  }
+  heap_place(pos, node);
+}
+
+void Scheduler::heap_sift_down(uint8_t pos) {
+  TaskNode* node = run_queue[pos];
+  for (;;) {
+    uint16_t child = 2 * pos + 1;  // 16 bits: 2 * pos + 1 wraps above 127 tasks
+    if (child >= run_queue_len) break;
+    if (child + 1 < run_queue_len && due_before(run_queue[child + 1], run_queue[child])) {
+      child++;
+    }
+    if (!due_before(run_queue[child], node)) break;
+    heap_place(pos, run_queue[child]);
+    pos = child;
+  }
+  heap_place(pos, node);
+}
+
+void Scheduler::heap_insert(TaskNode* node) {
+  if (node->heap_pos != TaskNode::NOT_QUEUED || run_queue_len >= FSMOS_MAX_TASKS) return;
+  heap_place(run_queue_len++, node);
+  heap_sift_up(node->heap_pos);
+}
+
+void Scheduler::heap_remove(TaskNode* node) {
+  uint8_t pos = node->heap_pos;
+  if (pos == TaskNode::NOT_QUEUED) return;
+  node->heap_pos = TaskNode::NOT_QUEUED;
+  TaskNode* last = run_queue[--run_queue_len];
+  if (pos == run_queue_len) return;
+  heap_place(pos, last);
+  heap_sift_down(pos);
+  heap_sift_up(last->heap_pos);
+}
+
+/**
+ * @brief Put a task on the run queue, or re-sort it after next_due changed
+ * @param t Task whose schedule changed
+ */
+void Scheduler::schedule_task(Task* t) {
+  TaskNode* node = find_task_node(t->id);
+  if (!node) return;
+  if (node->heap_pos == TaskNode::NOT_QUEUED) {
+    heap_insert(node);
+  } else {
+    heap_sift_down(node->heap_pos);
+    heap_sift_up(node->heap_pos);
+  }
+}
+
+/**
+ * @brief Take a task off the run queue
+ * @param t Task that stopped running (suspended or terminated)
+ */
+void Scheduler::unschedule_task(Task* t) {
+  TaskNode* node = find_task_node(t->id);
+  if (node) heap_remove(node);
+}
+
+void Scheduler::add_isr_source(IsrSource& source) {
+  for (IsrSource* src = isr_sources; src; src = src->next) {
+    if (src == &source) return;
   }
-  
-  return message_queue.push(SharedMsg(data));
+  source.next = isr_sources;
+  isr_sources = &source;
 }
 
 /**
- * @brief Execute one iteration of the scheduler
+ * @brief Move events queued by interrupt handlers onto the bus
  * 
- * This is the core scheduling loop that:
- * 1. Updates system time
- * 2. Delivers pending messages
- * 3. Executes due tasks
- * 4. Handles task cleanup
- * 5. Updates task statistics
- * 6. Manages watchdog
+ * Takes at most the events present on entry from each source, so an
+ * interrupt storm cannot keep loop_once() here. Events that cannot be
+ * posted (pool or bus full, no receiver) are lost like any failed post().
+ */
+void Scheduler::drain_isr_sources() {
+  for (IsrSource* src = isr_sources; src; src = src->next) {
+    IsrEvent e;
+    for (uint8_t n = src->size(); n && src->pop(e); n--) {
+#if FSMOS_MSG_INLINE_SIZE >= 4
+      post(e.type, e.src_id, e.topic, e.arg, nullptr, false, &e.time_us, sizeof(e.time_us));
+#else
+      post(e.type, e.src_id, e.topic, e.arg, nullptr, false);
+#endif
+    }
+  }
+}
+
+/**
+ * @brief Hand one message to a task
  * 
- * The scheduler ensures:
- * - Tasks run in their configured periods
- * - Messages are delivered promptly
- * - Resources are cleaned up
- * - System remains responsive
+ * Active tasks get on_msg() right away unless older messages still wait
+ * in their mailbox, in which case the message queues behind them.
+ * Suspended tasks keep it in their mailbox if they queue messages while
+ * suspended; otherwise it is counted as discarded.
  */
-void Scheduler::loop_once() {
-  // 1. Update time
-  uint32_t now = millis();
-  ms = now;
+void Scheduler::dispatch(TaskNode* node, const SharedMsg& msg) {
+  Task* task = node->task;
+  if (!task || task->is_inactive()) return;
 
-  // 2. Deliver all messages from the global bus
-  deliver();
+  if (task->is_active() && task->suspended_msg_queue.empty()) {
+    reset_info.last_task_id = node->id;
+    trace(TRACE_MSG_DELIVER, msg->type, node->id);
+#if FSMOS_STACK_MONITOR && defined(__AVR__)
+    uint16_t sp_before = begin_stack_probe();
+    task->on_msg(*msg.get());
+    probe_stack(node, sp_before);
+#else
+    task->on_msg(*msg.get());
+#endif
+    wake_task(node);
+  } else if (task->is_active() || task->queue_messages_while_suspended) {
+    // Overflow is counted by the mailbox itself
+    task->suspended_msg_queue.push(msg);
+    if (task->is_active()) mailbox_pending = true;
+  } else {
+    if (bus_discarded < 0xFFFF) bus_discarded++;
+    return;
+  }
 
-  // 3. Execute due tasks and handle cleanup
-  TaskNode** curr = &task_list;
-  while (*curr) {
-    TaskNode* node = *curr;
-    Task* task = node->task;
-    bool delete_task = false;
+#if FSMOS_TOPIC_STATS
+  uint8_t topic = msg->topic;
+  if (topic < FSMOS_MAX_TOPICS && topic_stats[topic].recipients != 0xFFFF) topic_stats[topic].recipients++;
+#endif
+}
 
-    if (task) {
-      if (task->is_inactive()) {
-        // Mark for deletion
-        delete_task = true;
-      }
-      else if (task->is_active() && (int32_t)(now - task->next_due) >= 0) {
-        // Only execute if task is active (not suspended or inactive)
-        // WDT & Profiling Start
-        reset_info.last_task_id = node->id;
-        uint32_t start_us = micros();
-
-        task->step();
-
-        // Profiling End
-        uint32_t exec_time = micros() - start_us;
-        node->stats.total_exec_time_us += exec_time;
-        if (exec_time > node->stats.max_exec_time_us) {
-          node->stats.max_exec_time_us = exec_time;
-        }
-        node->stats.run_count++;
-
-        // Schedule next run
-        task->next_due += task->get_period();
-        
-        // Handle missed deadlines
-        if ((int32_t)(task->next_due - now) < 0) {
-          task->next_due = now + task->get_period();
-        }
+#if FSMOS_TOPIC_STATS
+/**
+ * @brief Account a message taken off the bus in its topic's statistics
+ * @param data Message that was just delivered
+ * @param start_us micros() when it was taken off the bus
+ */
+void Scheduler::record_delivery(const MsgData* data, uint32_t start_us) {
+  if (data->topic >= FSMOS_MAX_TOPICS) return;
+  TopicStats& stats = topic_stats[data->topic];
+  uint32_t latency = start_us - data->post_us;
+  uint32_t busy = micros() - start_us;
+
+  if (stats.delivered != 0xFFFF) stats.delivered++;
+  if (latency > stats.max_latency_us) {
+    stats.max_latency_us = latency > 0xFFFF ? 0xFFFF : (uint16_t)latency;
+  }
+  stats.total_latency_us = (stats.total_latency_us > 0xFFFFFFFFUL - latency) ? 0xFFFFFFFFUL
+                                                                             : stats.total_latency_us + latency;
+  stats.bus_us = (stats.bus_us > 0xFFFFFFFFUL - busy) ? 0xFFFFFFFFUL : stats.bus_us + busy;
+}
+#endif
+
+/**
+ * @brief Check the per-iteration delivery budget
+ * @return true once delivery has to stop for this loop_once()
+ */
+bool Scheduler::budget_spent(uint8_t delivered, uint32_t start_us) const {
+  return delivered > 0 &&
+         ((delivery_budget_msgs && delivered >= delivery_budget_msgs) ||
+          (delivery_budget_us && (uint32_t)(micros() - start_us) >= delivery_budget_us));
+}
+
+/**
+ * @brief Deliver messages held in the mailboxes of active tasks
+ * 
+ * Runs before the bus so a resumed task sees its backlog before anything
+ * newer. Stops when the budget runs out and resumes next iteration.
+ */
+void Scheduler::drain_mailboxes(uint8_t& delivered, uint32_t start_us) {
+  mailbox_pending = false;
+  for (TaskNode* curr = task_list; curr; curr = curr->next) {
+    Task* task = curr->task;
+    // on_msg() may suspend the task again, which leaves the rest queued
+    while (task && task->is_active() && !task->suspended_msg_queue.empty()) {
+      if (budget_spent(delivered, start_us)) {
+        mailbox_pending = true;
+        return;
       }
-    }
+      delivered++;
 
-    if (delete_task) {
-      // Remove and delete the task
-      *curr = node->next;
-      delete task;       // This will call on_terminate()
-      delete node;
-      task_count--;
-    } else {
-      curr = &(node->next);
+      SharedMsg msg;
+      if (!task->suspended_msg_queue.pop(msg)) break;
+      reset_info.last_task_id = curr->id;
+      trace(TRACE_MSG_DELIVER, msg->type, curr->id);
+#if FSMOS_STACK_MONITOR && defined(__AVR__)
+      uint16_t sp_before = begin_stack_probe();
+      task->on_msg(*msg.get());
+      probe_stack(curr, sp_before);
+#else
+      task->on_msg(*msg.get());
+#endif
+      wake_task(curr);
     }
   }
-  
-  // 4. Pet the watchdog
-  if (watchdog_enabled) {
-    wdt_reset();
-  }
 }
 
 /**
  * @brief Deliver pending messages to tasks
  * 
- * Iterates through all active tasks and processes their pending
- * messages. For each task:
- * - Checks if task is active
- * - Processes queued messages
- * - Handles message cleanup
+ * Routes each message on the bus to its destination task or the
+ * topic's subscribers. Messages for suspended tasks are kept in their
+ * mailboxes and delivered after activate(), before newer bus traffic.
  * 
- * This method ensures messages are delivered in a fair manner
- * and maintains system responsiveness.
+ * Delivery stops once the per-iteration budget (message count and/or
+ * microseconds) is used up, so handlers that keep publishing cannot
+ * starve step() or the watchdog. Remaining messages keep their FIFO
+ * order and are delivered first in the next iteration.
  */
 void Scheduler::deliver() {
-  // Process all messages in the queue
+  uint8_t delivered = 0;
+  uint32_t start_us = micros();
+
+  if (mailbox_pending) drain_mailboxes(delivered, start_us);
+
   while (!message_queue.empty()) {
+    if (budget_spent(delivered, start_us)) {
+      uint16_t left = message_queue.size();
+      bus_deferred = (bus_deferred > 0xFFFF - left) ? 0xFFFF : bus_deferred + left;
+      break;
+    }
+    delivered++;
+
     SharedMsg msg;
     if (!message_queue.pop(msg)) break;
+#if FSMOS_TOPIC_STATS
+    uint32_t msg_start_us = micros();
+#endif
     
     if (msg->topic == 0) {
       // Direct message - deliver to specific task
       TaskNode* target_node = find_task_node(msg->src_id);
-      if (target_node && target_node->task && target_node->task->is_active()) {
-        target_node->task->on_msg(*msg.get());
-      }
+      if (target_node) dispatch(target_node, msg);
     } else {
       // Topic-based message - deliver to all subscribed tasks
-      TaskNode* curr = task_list;
-      while (curr) {
-        if (curr->task && curr->task->is_active() && curr->task->is_subscribed_to(msg->topic)) {
-          curr->task->on_msg(*msg.get());
+      if (topic_index_dirty) rebuild_topic_index();
+      if (!topic_index_full) {
+        // Handlers may subscribe or add tasks, which only marks the index
+        // dirty; the range captured here stays valid until the next message
+        uint8_t end = topic_start[msg->topic + 1];
+        for (uint8_t i = topic_start[msg->topic]; i < end; i++) {
+          TaskNode* node = topic_subscribers[i];
+          if (node) dispatch(node, msg);
+        }
+      } else {
+        TaskNode* curr = task_list;
+        while (curr) {
+          if (curr->task && curr->task->is_subscribed_to(msg->topic)) {
+            dispatch(curr, msg);
+          }
+          curr = curr->next;
         }
-        curr = curr->next;
       }
     }
+#if FSMOS_TOPIC_STATS
+    record_delivery(msg.get(), msg_start_us);
+#endif
+  }
+}
+
+/**
+ * @brief Count the subscribers of a topic
+ * 
+ * Uses the topic index when it is current. While it is dirty (for
+ * example while a handler subscribes mid-delivery) the task list is
+ * scanned instead, so the index is never rebuilt under deliver().
+ * 
+ * @param topic Topic ID (1 to FSMOS_MAX_TOPICS-1)
+ * @return Number of tasks subscribed to the topic
+ */
+uint8_t Scheduler::count_subscribers(uint8_t topic) const {
+  if ((uint16_t)topic >= FSMOS_MAX_TOPICS) return 0;
+  if (!topic_index_dirty && !topic_index_full) {
+    return topic_start[topic + 1] - topic_start[topic];
+  }
+  uint8_t count = 0;
+  for (TaskNode* curr = task_list; curr; curr = curr->next) {
+    if (curr->task && curr->task->is_subscribed_to(topic)) count++;
+  }
+  return count;
+}
+
+/**
+ * @brief Rebuild the topic->subscriber index from the task bitmaps
+ * 
+ * Runs lazily, only after subscribe(), add() or a task removal marked
+ * the index dirty. Subscribers keep task list order. If the index has
+ * fewer than the needed FSMOS_MAX_SUBSCRIPTIONS entries, delivery falls
+ * back to scanning all tasks.
+ */
+void Scheduler::rebuild_topic_index() {
+  uint8_t total = 0;
+  topic_index_full = false;
+  topic_start[0] = 0;
+  for (uint16_t topic = 1; topic < FSMOS_MAX_TOPICS; topic++) {
+    topic_start[topic] = total;
+    for (TaskNode* curr = task_list; curr; curr = curr->next) {
+      if (!curr->task || !curr->task->is_subscribed_to(topic)) continue;
+      if (total == FSMOS_MAX_SUBSCRIPTIONS) {
+        topic_index_full = true;
+        break;
+      }
+      topic_subscribers[total++] = curr;
+    }
+  }
+  topic_start[FSMOS_MAX_TOPICS] = total;
+  topic_index_dirty = false;
+}
+
+/**
+ * @brief Drop a task node from the topic index before it is freed
+ * @param node Node being removed from the scheduler
+ */
+void Scheduler::unindex_task(TaskNode* node) {
+  for (uint8_t i = 0; i < FSMOS_MAX_SUBSCRIPTIONS; i++) {
+    if (topic_subscribers[i] == node) topic_subscribers[i] = nullptr;
   }
+  topic_index_dirty = true;
 }
 
 
@@ -327,25 +1600,142 @@ void Scheduler::enable_watchdog(uint8_t timeout) {
 
 bool Scheduler::get_reset_info(ResetInfo& info) {
   info = reset_info;
-  // Clear last task ID after reading to avoid stale info on next reset
-  reset_info.last_task_id = 255; 
+  info.last_task_id = reset_task_id;  // begin() already cleared the live copy
+  return true;
+}
+
+bool Scheduler::get_trace_record(uint8_t index, TraceRecord& record) const {
+#if FSMOS_TRACE_SIZE
+  if (index >= trace_buf.count) return false;
+  record = trace_buf.records[(uint8_t)(trace_buf.head - trace_buf.count + index) & (FSMOS_TRACE_SIZE - 1)];
   return true;
+#else
+  (void)index;
+  (void)record;
+  return false;
+#endif
+}
+
+void Scheduler::restart_trace() {
+#if FSMOS_TRACE_SIZE
+  trace_buf.magic = TRACE_MAGIC;
+  trace_buf.head = 0;
+  trace_buf.count = 0;
+  trace_buf.frozen = 0;
+#endif
+  reset_info.trace_count = 0;
+}
+
+bool Scheduler::is_trace_frozen() const {
+#if FSMOS_TRACE_SIZE
+  return trace_buf.frozen;
+#else
+  return false;
+#endif
+}
+
+#if FSMOS_STACK_MONITOR && defined(__AVR__)
+/**
+ * @brief Repaint what scheduler code used below SP before a probed call
+ * 
+ * Delivery, timers, logging and interrupts write below the scheduler's
+ * frame between task calls. Painting that over first means only the
+ * call's own use shows up in probe_stack(). Inlined, like the scans, so
+ * none of this leaves a frame of its own below SP.
+ * 
+ * @return Stack pointer before the call, for probe_stack()
+ */
+inline __attribute__((always_inline)) uint16_t Scheduler::begin_stack_probe() {
+  uint16_t floor = heap_end();
+  if (floor < stack_paint_floor) {
+    // The heap shrank; paint the memory it gave back to the stack
+    uint8_t* p = (uint8_t*)floor;
+    while ((uint16_t)p < stack_paint_floor) *p++ = STACK_PAINT;
+  }
+  stack_paint_floor = floor;
+
+  uint16_t sp = SP;
+  repaint_stack(stack_reach(sp, floor));
+  return sp;
+}
+
+/**
+ * @brief Record how deep a step() or on_msg() call went, then repaint
+ * 
+ * begin_stack_probe() left everything below sp_before painted, so the
+ * lowest byte that is not paint is as deep as the call (and any ISR
+ * that hit meanwhile) went. The peak counts from sp_before, so it does
+ * not depend on how deep in the scheduler the call was made.
+ * 
+ * The scan stops at FSMOS_STACK_SCAN_SLACK paint bytes in a row. A
+ * longer unwritten hole in a frame hides the stack below it; raise the
+ * slack for tasks with large local buffers.
+ * 
+ * @param node Task that just ran
+ * @param sp_before Stack pointer before the call
+ */
+inline __attribute__((always_inline)) void Scheduler::probe_stack(TaskNode* node, uint16_t sp_before) {
+  uint16_t low = stack_reach(sp_before, heap_end());
+  uint16_t peak = sp_before + 1 - low;
+  if (peak > node->stack_peak) node->stack_peak = peak;
+  if (low < node->stack_low) node->stack_low = low;
+  if (low < stack_low_water) stack_low_water = low;
+  repaint_stack(low);
+}
+#endif
+
+#if !defined(FSMOS_DISABLE_LEAK_DETECTION)
+/**
+ * @brief Charge a heap allocation to the task that is running
+ * @param bytes Chunk size the allocation took
+ */
+void Scheduler::charge_allocation(uint16_t bytes) {
+  TaskNode* node = find_task_node(reset_info.last_task_id);
+  if (!node) return;
+  if (node->heap_allocs != 0xFFFF) node->heap_allocs++;
+  node->heap_bytes = (node->heap_bytes > 0xFFFF - bytes) ? 0xFFFF : node->heap_bytes + bytes;
 }
+#endif
 
+void Scheduler::enable_stack_monitoring() {
 #if defined(__AVR__)
-// Memory markers
-static const uint8_t HEAP_FREE_MARKER = 0xFF;
-static const uint16_t STACK_CANARY = 0xFEED;
+  uint16_t floor = heap_end();
+  repaint_stack(floor);
+#if FSMOS_STACK_MONITOR
+  stack_paint_floor = floor;
+  stack_low_water = SP;
+  for (TaskNode* curr = task_list; curr; curr = curr->next) {
+    curr->stack_peak = 0;
+    curr->stack_low = 0xFFFF;
+  }
+#endif
+#endif
+}
+
+int Scheduler::get_free_stack() const {
+#if defined(__AVR__)
+  uint16_t floor = heap_end();
+#if FSMOS_STACK_MONITOR
+  // Memory the heap gave back since the last probe is not painted yet
+  uint16_t low = first_used(floor > stack_paint_floor ? floor : stack_paint_floor, SP);
+  if (stack_low_water < low) low = stack_low_water;
+#else
+  uint16_t low = first_used(floor, SP);
+#endif
+  return low > floor ? low - floor : 0;
+#else
+  return 0;
 #endif
+}
 
 /**
  * @brief Get memory usage information for a task
  * 
  * Calculates memory used by a task including:
  * - Task object size
- * - Subscription array size
- * - Message queue size
- * - Total allocated memory
+ * - Subscription bitmap size (part of the task object)
+ * - Message queue size (part of the task object)
+ * - Total footprint including the scheduler node
  * 
  * @param task_id ID of task to analyze
  * @param info Reference to store memory info
@@ -357,23 +1747,76 @@ bool Scheduler::get_task_memory_info(uint8_t task_id, TaskMemoryInfo& info) cons
 
     Task* task = node->task;
     info.task_struct_size = sizeof(Task);
-    info.subscription_size = task->subscription_count;
-    info.queue_size = sizeof(LinkedQueue<SharedMsg>);
+    info.subscription_size = sizeof(task->subscriptions);
+    info.queue_size = sizeof(TaskQueue);
     
-    // Calculate total allocated memory
-    info.total_allocated = info.task_struct_size + 
-                          info.subscription_size +
-                          info.queue_size;
+    // Subscription bitmap, queue header and scheduler node all live
+    // inside the Task object
+    info.total_allocated = info.task_struct_size;
+
+#if FSMOS_STACK_MONITOR && defined(__AVR__)
+    uint16_t floor = heap_end();
+    info.stack_peak = node->stack_peak;
+    info.stack_headroom = (node->stack_peak && node->stack_low > floor) ? node->stack_low - floor : 0;
+#else
+    info.stack_peak = 0;
+    info.stack_headroom = 0;
+#endif
+
+#if !defined(FSMOS_DISABLE_LEAK_DETECTION)
+    // Same window as the task and idle statistics
+    uint32_t window_ms = millis() - idle_window_start;
+    info.heap_allocs = node->heap_allocs;
+    info.heap_bytes = node->heap_bytes;
+    info.allocs_per_min = window_ms ? (uint32_t)node->heap_allocs * 60000UL / window_ms : 0;
+#else
+    info.heap_allocs = 0;
+    info.heap_bytes = 0;
+    info.allocs_per_min = 0;
+#endif
     
     return true;
 }
 
+void Scheduler::get_bus_stats(BusStats& stats) const {
+    stats.pending = message_queue.size();
+    stats.high_water = message_queue.high_water();
+    stats.dropped = message_queue.dropped();
+    stats.merged = bus_merged;
+    stats.deferred = bus_deferred;
+    stats.discarded = bus_discarded;
+}
+
+#if FSMOS_TOPIC_STATS
+bool Scheduler::get_topic_stats(uint8_t topic, TopicStats& stats) const {
+    if (topic >= FSMOS_MAX_TOPICS) return false;
+    stats = topic_stats[topic];
+    return true;
+}
+
+void Scheduler::reset_topic_stats() {
+    memset(topic_stats, 0, sizeof(topic_stats));
+}
+#endif
+
+bool Scheduler::get_mailbox_stats(uint8_t task_id, MailboxStats& stats) const {
+    TaskNode* node = find_task_node(task_id);
+    if (!node || !node->task) return false;
+
+    const TaskQueue& mailbox = node->task->suspended_msg_queue;
+    stats.pending = mailbox.size();
+    stats.capacity = FSMOS_TASK_QUEUE_SIZE;
+    stats.high_water = mailbox.high_water();
+    stats.dropped = mailbox.dropped();
+    return true;
+}
+
 bool Scheduler::get_system_memory_info(SystemMemoryInfo& info) const {
 #if defined(__AVR__)
     extern int __heap_start, *__brkval;
     extern uint8_t __data_start, __data_end;
     extern uint8_t __bss_start, __bss_end;
-    extern uint8_t _etext, __stack;
+    extern uint8_t _etext;
     
     // Static Memory
     info.total_ram = RAMEND - RAMSTART + 1;
@@ -387,29 +1830,34 @@ bool Scheduler::get_system_memory_info(SystemMemoryInfo& info) const {
     
     // Task Memory
     info.total_tasks = task_count;
-    info.task_memory = task_count * (sizeof(TaskNode) + sizeof(Task));
+    // The TaskNode is part of Task. Only the base class size is known
+    // here; members a subclass adds are not counted.
+    info.task_memory = task_count * sizeof(Task);
     
-    // Message Memory
-    uint8_t msg_count = 0;
-    uint16_t msg_mem = 0;
-    TaskNode* curr = task_list;
-    while (curr) {
+    // Message Memory: every message in flight (bus, mailboxes, timers)
+    // holds one pool slot however many queues reference it
+    MsgPoolStats pool;
+    msg_pool.get_stats(pool);
+    info.active_messages = pool.in_use;
+    info.message_memory = sizeof(msg_pool) + sizeof(message_queue) +
+                          sizeof(timer_msgs) + sizeof(timer_due) + sizeof(timer_generation) + sizeof(timer_order) +
+                          task_count * sizeof(TaskQueue);  // Mailboxes, part of each Task
+#if FSMOS_BUS_QUEUE_SIZE == 0
+    // Heap nodes of the LinkedQueue bus
+    info.message_memory += message_queue.size() * (sizeof(SharedMsg) + sizeof(void*));
+#endif
+#if FSMOS_TASK_QUEUE_SIZE == 0
+    // Heap nodes of the LinkedQueue mailboxes
+    for (TaskNode* curr = task_list; curr; curr = curr->next) {
         if (curr->task) {
-            msg_count += curr->task->suspended_msg_queue.size();
-            msg_mem += sizeof(MsgData) * curr->task->suspended_msg_queue.size();
+            info.message_memory += curr->task->suspended_msg_queue.size() * (sizeof(SharedMsg) + sizeof(void*));
         }
-        curr = curr->next;
     }
-    info.active_messages = msg_count;
-    info.message_memory = msg_mem;
+#endif
     
-    // Stack Memory
-    info.stack_size = RAMEND - (uint16_t)&__stack;
-    uint16_t* p = (uint16_t*)RAMEND;
-    while (p > (uint16_t*)&__stack && *p == STACK_CANARY) {
-        p--;
-    }
-    info.stack_free = (uint16_t)RAMEND - (uint16_t)p;
+    // Stack Memory: everything between the heap and RAMEND
+    info.stack_size = RAMEND + 1 - heap_end();
+    info.stack_free = get_free_stack();
     info.stack_used = info.stack_size - info.stack_free;
     
     // Program Memory
@@ -434,11 +1882,48 @@ uint16_t Scheduler::get_free_memory() const {
 #endif
 }
 
+/**
+ * @brief Layout of a chunk on avr-libc's free list
+ * 
+ * sz is the chunk's usable size; the 2-byte size field sits in front of
+ * it, and nx overlays the first bytes of the usable area.
+ */
+struct HeapFreeChunk {
+    size_t sz;
+    HeapFreeChunk* nx;
+};
+
+void Scheduler::get_heap_snapshot(HeapSnapshot& snapshot) const {
+    memset(&snapshot, 0, sizeof(snapshot));
+#if defined(__AVR__)
+    extern int __heap_start, *__brkval;
+    extern HeapFreeChunk* __flp;
+
+    uint16_t bottom = (uint16_t)&__heap_start;
+    uint16_t top = __brkval == 0 ? bottom : (uint16_t)__brkval;
+    snapshot.heap_size = top - bottom;
+    snapshot.unallocated = get_free_memory();
+
+    // The list is sorted by address; stop on anything outside the heap
+    // rather than follow a corrupted link
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        for (HeapFreeChunk* chunk = __flp; chunk; chunk = chunk->nx) {
+            uint16_t addr = (uint16_t)chunk;
+            if (addr < bottom || addr >= top || snapshot.free_blocks == 0xFF) break;
+            snapshot.free_blocks++;
+            snapshot.free_list_bytes += chunk->sz;
+            if (chunk->sz > snapshot.largest_free) snapshot.largest_free = chunk->sz;
+        }
+    }
+#endif
+}
+
 uint16_t Scheduler::get_largest_block() const {
 #if defined(__AVR__)
-    // Simplified implementation - return free memory as largest block
-    // This is not perfect but works for basic monitoring
-    return get_free_memory();
+    // Either a freed chunk or fresh memory above the heap's top
+    HeapSnapshot heap;
+    get_heap_snapshot(heap);
+    return heap.largest_free > heap.unallocated ? heap.largest_free : heap.unallocated;
 #else
     return 0;
 #endif
@@ -446,11 +1931,14 @@ uint16_t Scheduler::get_largest_block() const {
 
 uint8_t Scheduler::get_heap_fragmentation() const {
 #if defined(__AVR__)
-    uint16_t total_free = get_free_memory();
-    uint16_t largest = get_largest_block();
-    
+    // Share of free memory that the largest allocation could not use
+    HeapSnapshot heap;
+    get_heap_snapshot(heap);
+    uint32_t total_free = (uint32_t)heap.free_list_bytes + heap.unallocated;
+    uint16_t largest = heap.largest_free > heap.unallocated ? heap.largest_free : heap.unallocated;
+
     if (total_free == 0) return 100;
-    return (uint8_t)(100 - (largest * 100) / total_free);
+    return (uint8_t)(100 - (largest * 100UL) / total_free);
 #else
     return 0;
 #endif
@@ -458,9 +1946,9 @@ uint8_t Scheduler::get_heap_fragmentation() const {
 
 uint8_t Scheduler::count_heap_fragments() const {
 #if defined(__AVR__)
-    // Simplified implementation - return 1 for basic monitoring
-    // This is not perfect but works for basic monitoring
-    return 1;
+    HeapSnapshot heap;
+    get_heap_snapshot(heap);
+    return heap.free_blocks;
 #else
     return 0;
 #endif
@@ -471,12 +1959,36 @@ uint8_t Scheduler::get_task_count() const {
 }
 
 TaskNode* Scheduler::find_task_node(uint8_t task_id) const {
-    TaskNode* curr = task_list;
-    while (curr) {
-        if (curr->id == task_id) {
-            return curr;
-        }
-        curr = curr->next;
+    uint8_t slot = task_id & FSMOS_TASK_SLOT_MASK;
+    if (slot >= FSMOS_MAX_TASKS) return nullptr;
+    TaskNode* node = task_slots[slot];
+    // A stale ID has an older generation than the slot's current occupant
+    return (node && node->id == task_id) ? node : nullptr;
+}
+
+/**
+ * @brief Free a task's slot, advance its generation and empty its mailbox
+ * 
+ * The next task placed in the slot gets a different ID, so handles to
+ * the removed task stop resolving. Messages still waiting in the mailbox
+ * are released so their pool slots come back now, not when (or if) the
+ * task object is destroyed.
+ * 
+ * @param node Node of the task being removed
+ */
+void Scheduler::release_slot(TaskNode* node) {
+    uint8_t slot = node->id & FSMOS_TASK_SLOT_MASK;
+    task_slots[slot] = nullptr;
+    slot_generation[slot] = (node->id >> FSMOS_TASK_SLOT_BITS) + 1;
+
+    SharedMsg msg;
+    while (node->task->suspended_msg_queue.pop(msg)) { msg.release(); }
+}
+
+Task* Scheduler::next_task(uint8_t& cursor) const {
+    while (cursor < FSMOS_MAX_TASKS) {
+        TaskNode* node = task_slots[cursor++];
+        if (node && node->task) return node->task;
     }
     return nullptr;
 }
@@ -495,6 +2007,17 @@ bool Scheduler::get_task_stats(uint8_t task_id, TaskStats& stats) const {
     return false;
 }
 
+void Scheduler::reset_task_stats() {
+    for (TaskNode* curr = task_list; curr; curr = curr->next) {
+        curr->stats = TaskStats();
+#if !defined(FSMOS_DISABLE_LEAK_DETECTION)
+        curr->heap_allocs = 0;
+        curr->heap_bytes = 0;
+#endif
+    }
+    reset_idle_stats();
+}
+
 /* ================== Task Implementation ================== */
 
 /**
@@ -511,6 +2034,37 @@ bool Task::tell(uint8_t dst_task_id, uint8_t type, uint16_t arg, void* ptr, bool
   return OS.post(type, dst_task_id, 0, arg, ptr, is_dynamic);
 }
 
+/**
+ * @brief Send a direct message after a delay
+ * 
+ * @param delay_ms Milliseconds from now
+ * @param dst_task_id Destination task ID
+ * @param type Message type
+ * @param arg Optional 16-bit argument
+ * @param ptr Optional pointer to additional data
+ * @param is_dynamic Whether ptr points to dynamically allocated memory
+ * @return Handle for cancel_timer(), or TIMER_NONE on failure
+ */
+TimerHandle Task::tell_after(uint32_t delay_ms, uint8_t dst_task_id, uint8_t type, uint16_t arg, void* ptr, bool is_dynamic) {
+  return OS.post_after(delay_ms, type, dst_task_id, 0, arg, ptr, is_dynamic);
+}
+
+/**
+ * @brief Publish a message to a topic after a delay
+ * 
+ * @param delay_ms Milliseconds from now
+ * @param topic Topic ID (must be non-zero)
+ * @param type Message type
+ * @param arg Optional 16-bit argument
+ * @param ptr Optional pointer to additional data
+ * @param is_dynamic Whether ptr points to dynamically allocated memory
+ * @return Handle for cancel_timer(), or TIMER_NONE on failure
+ */
+TimerHandle Task::publish_after(uint32_t delay_ms, uint8_t topic, uint8_t type, uint16_t arg, void* ptr, bool is_dynamic) {
+  if (topic == 0) return TIMER_NONE; // Topic 0 is reserved for direct messages
+  return OS.post_after(delay_ms, type, id, topic, arg, ptr, is_dynamic);
+}
+
 /**
  * @brief Publish a message to a topic
  * 
@@ -532,39 +2086,18 @@ bool Task::publish(uint8_t topic, uint8_t type, uint16_t arg, void* ptr, bool is
  * @brief Subscribe to a topic
  * 
  * Allows task to receive messages published to the specified topic.
+ * Sets the topic's bit in the task's subscription bitmap.
  * 
- * @param topic Topic ID to subscribe to (1-255)
+ * @param topic Topic ID to subscribe to (1 to FSMOS_MAX_TOPICS-1)
+ * @return true if the topic is valid and now subscribed
  */
-void Task::subscribe(uint8_t topic) {
-  if (topic == 0) return; // topic 0 reserved
-  // Avoid duplicates
-  SubNode* curr = subscription_head;
-  while (curr) {
-    if (curr->topic == topic) return;
-    curr = curr->next;
-  }
-  // Prepend new subscription
-  SubNode* node = new SubNode(topic);
-  node->next = subscription_head;
-  subscription_head = node;
+bool Task::subscribe(uint8_t topic) {
+  if (topic == 0 || (uint16_t)topic >= FSMOS_MAX_TOPICS) return false; // topic 0 reserved
+  if (is_subscribed_to(topic)) return true;  // Avoid duplicates
+  subscriptions[topic >> 3] |= (1 << (topic & 7));
   if (subscription_count < 255) subscription_count++;
-  
-}
-
-/**
- * @brief Check if task is subscribed to a topic
- * 
- * @param topic Topic ID to check
- * @return true if task is subscribed to topic
- */
-bool Task::is_subscribed_to(uint8_t topic) {
-  if (topic == 0) return false;
-  SubNode* curr = subscription_head;
-  while (curr) {
-    if (curr->topic == topic) return true;
-    curr = curr->next;
-  }
-  return false;
+  OS.topic_index_dirty = true;
+  return true;
 }
 
 /**
@@ -572,16 +2105,18 @@ bool Task::is_subscribed_to(uint8_t topic) {
  * 
  * If task was suspended:
  * - Calls on_resume() handler
- * - Processes queued messages
+ * - Has its mailbox drained before newer bus messages
  * - Schedules next execution
  */
 void Task::activate() {
   if (state == SUSPENDED) {
     on_resume();
-    // Will process any queued message on next scheduler loop
+    // Queued messages are delivered at the start of the next deliver()
+    if (!suspended_msg_queue.empty()) OS.mailbox_pending = true;
   }
   state = ACTIVE;
   next_due = OS.now() + period_ms;
+  if (period_ms) OS.schedule_task(this);
 }
 
 /**
@@ -596,6 +2131,7 @@ void Task::suspend() {
   if (state == ACTIVE) {
     on_suspend();
     state = SUSPENDED;
+    OS.unschedule_task(this);
     // Keep any queued message for when we resume
   }
 }
@@ -609,6 +2145,8 @@ void Task::suspend() {
  */
 void Task::terminate() {
   state = INACTIVE;
+  OS.unschedule_task(this);
+  OS.reap_pending = true;
 }
 
 uint8_t Task::get_id() const {
@@ -616,7 +2154,13 @@ uint8_t Task::get_id() const {
 }
 
 void Task::set_period(uint16_t period) {
+  bool was_event_driven = (period_ms == 0);
   period_ms = period;
+  // Leaving event-driven mode: start the periodic schedule from now
+  if (was_event_driven && period && is_active()) {
+    next_due = OS.now() + period;
+    OS.schedule_task(this);
+  }
 }
 
 uint16_t Task::get_period() const {
@@ -630,3 +2174,96 @@ void Task::set_queue_messages_while_suspended(bool queue_messages) {
 bool Task::get_queue_messages_while_suspended() const {
   return queue_messages_while_suspended;
 }
+
+LogLevel Task::get_log_level() const {
+  for (uint8_t level = LOG_DEBUG; level <= LOG_ERROR; level++) {
+    if ((log_levels >> level) & 1) return (LogLevel)level;
+  }
+  return LOG_NONE;
+}
+
+#if FSMOS_PIN_CHANGE_INPUT
+/* ================== Pin-change Input ================== */
+#if defined(__AVR__) && !defined(__AVR_ATmega328P__)
+#error "PinChangeInput supports the ATmega328P pin layout only"
+#endif
+
+IsrQueue<FSMOS_PIN_CHANGE_QUEUE_SIZE> PinChangeInput::queue;
+uint8_t PinChangeInput::watched[PinChangeInput::PORT_COUNT];
+uint8_t PinChangeInput::levels[PinChangeInput::PORT_COUNT];
+uint8_t PinChangeInput::topics[PinChangeInput::PORT_COUNT];
+uint8_t PinChangeInput::types[PinChangeInput::PORT_COUNT];
+
+/**
+ * @brief Port index of a pin: 0 = B (PCINT0), 1 = C (PCINT1), 2 = D (PCINT2)
+ * @return PORT_COUNT if the pin has no pin-change interrupt
+ */
+uint8_t PinChangeInput::port_of(uint8_t pin) {
+  if (pin < 8) return 2;
+  if (pin < 14) return 0;
+  if (pin < 20) return 1;
+  return PORT_COUNT;
+}
+
+uint8_t PinChangeInput::mask(uint8_t pin) {
+  if (pin < 8) return 1 << pin;
+  if (pin < 14) return 1 << (pin - 8);
+  if (pin < 20) return 1 << (pin - 14);
+  return 0;
+}
+
+bool PinChangeInput::watch(uint8_t pin, uint8_t topic, uint8_t type) {
+  uint8_t port = port_of(pin);
+  if (port == PORT_COUNT) return false;
+  if (watched[port] && (topics[port] != topic || types[port] != type)) return false;
+
+  OS.add_isr_source(queue);
+  topics[port] = topic;
+  types[port] = type;
+#if defined(__AVR__)
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    watched[port] |= mask(pin);
+    switch (port) {
+      case 0: levels[0] = PINB; PCMSK0 = watched[0]; break;
+      case 1: levels[1] = PINC; PCMSK1 = watched[1]; break;
+      default: levels[2] = PIND; PCMSK2 = watched[2]; break;
+    }
+    PCIFR = _BV(port);   // Drop any edge latched before the pin was watched
+    PCICR |= _BV(port);
+  }
+#else
+  watched[port] |= mask(pin);
+  if (digitalRead(pin)) levels[port] |= mask(pin);
+  else levels[port] &= ~mask(pin);
+#endif
+  return true;
+}
+
+/**
+ * @brief Post the watched pins of a port that changed since the last capture
+ * 
+ * Runs in interrupt context (or from inject()). Edges shorter than the
+ * interrupt latency can produce a call with nothing changed; those are
+ * ignored.
+ */
+void PinChangeInput::capture(uint8_t port, uint8_t now_levels) {
+  uint8_t changed = (now_levels ^ levels[port]) & watched[port];
+  if (!changed) return;
+  levels[port] = now_levels;
+  Scheduler::post_from_isr(queue, types[port], FSMOS_NO_TASK, topics[port],
+                           ((uint16_t)changed << 8) | (now_levels & watched[port]));
+}
+
+void PinChangeInput::inject(uint8_t pin, uint8_t level) {
+  uint8_t port = port_of(pin);
+  if (port == PORT_COUNT) return;
+  uint8_t now_levels = level ? (levels[port] | mask(pin)) : (levels[port] & ~mask(pin));
+  capture(port, now_levels);
+}
+
+#if defined(__AVR__)
+ISR(PCINT0_vect) { PinChangeInput::capture(0, PINB); }
+ISR(PCINT1_vect) { PinChangeInput::capture(1, PINC); }
+ISR(PCINT2_vect) { PinChangeInput::capture(2, PIND); }
+#endif
+#endif
@@ -29,12 +29,158 @@
 
 #if defined(__AVR__)
 #include <avr/wdt.h> // For watchdog timer
+#include <avr/sleep.h> // For idle sleep
 #endif
 
 // Forward declarations
 class Task;
 class Scheduler;
 
+/**
+ * @brief Order in which tasks that are due in the same iteration run
+ */
+enum SchedulingPolicy : uint8_t {
+  SCHED_EDF = 0,            ///< Earliest next_due first
+  SCHED_FIXED_PRIORITY = 1, ///< Highest Task priority first, ties by next_due
+  SCHED_ROUND_ROBIN = 2     ///< Least recently dispatched first
+};
+
+/* ================== Compile-time Configuration ================== */
+#ifndef FSMOS_MSG_POOL_SIZE
+#define FSMOS_MSG_POOL_SIZE 16  ///< Number of MsgData slots available to post()
+#endif
+
+#ifndef FSMOS_MSG_INLINE_SIZE
+#define FSMOS_MSG_INLINE_SIZE 4  ///< Bytes of inline payload carried in every MsgData (0 = none)
+#endif
+
+// Every pending timer holds its message in a pool slot until it fires, so
+// the pool must cover FSMOS_MAX_TIMERS plus what is in flight on the bus
+// and in mailboxes; otherwise armed timers starve post() and it drops events.
+#ifndef FSMOS_MAX_TIMERS
+#define FSMOS_MAX_TIMERS 8  ///< Delayed messages (post_at/tell_after/publish_after) pending at once
+#endif
+static_assert(FSMOS_MSG_POOL_SIZE > FSMOS_MAX_TIMERS,
+              "FSMOS_MSG_POOL_SIZE must exceed FSMOS_MAX_TIMERS: pending timers hold pool slots");
+
+#ifndef FSMOS_BUS_QUEUE_SIZE
+#define FSMOS_BUS_QUEUE_SIZE 16  ///< Global bus ring capacity (0 = heap-backed LinkedQueue)
+#endif
+
+#ifndef FSMOS_BUS_OVERFLOW_POLICY
+#define FSMOS_BUS_OVERFLOW_POLICY QUEUE_REJECT  ///< What the bus ring does when full
+#endif
+
+#ifndef FSMOS_MAX_TASKS
+#define FSMOS_MAX_TASKS 16  ///< Maximum number of tasks the scheduler can hold
+#endif
+
+// Task IDs are (generation << FSMOS_TASK_SLOT_BITS) | slot, see Scheduler::add()
+#if FSMOS_MAX_TASKS <= 4
+#define FSMOS_TASK_SLOT_BITS 2
+#elif FSMOS_MAX_TASKS <= 8
+#define FSMOS_TASK_SLOT_BITS 3
+#elif FSMOS_MAX_TASKS <= 16
+#define FSMOS_TASK_SLOT_BITS 4
+#elif FSMOS_MAX_TASKS <= 32
+#define FSMOS_TASK_SLOT_BITS 5
+#elif FSMOS_MAX_TASKS <= 64
+#define FSMOS_TASK_SLOT_BITS 6
+#else
+#error "FSMOS_MAX_TASKS must be 64 or less"
+#endif
+#define FSMOS_TASK_SLOT_MASK ((1 << FSMOS_TASK_SLOT_BITS) - 1)
+
+// The remaining bits count a slot's generations. An ID stays unique for
+// (1 << FSMOS_TASK_GEN_BITS) - 1 reuses of its slot and comes back on the
+// next one (a reuse sooner for the last slot, which skips the generation
+// that would be FSMOS_NO_TASK): 15 reuses with 16 tasks, 7 with 32 and
+// only 3 with 64. Code that keeps IDs of tasks that come and go should
+// stay at 32 tasks or fewer.
+#define FSMOS_TASK_GEN_BITS (8 - FSMOS_TASK_SLOT_BITS)
+static_assert(FSMOS_TASK_GEN_BITS >= 2, "Task IDs need at least 2 generation bits");
+
+/**
+ * Task ID that never names a task. add() returns it on failure, and it is
+ * the src_id of messages that do not come from a task (PinChangeInput
+ * edges), so a receiver cannot mistake them for a message from task 0.
+ */
+static const uint8_t FSMOS_NO_TASK = 255;
+
+#ifndef FSMOS_SCHED_POLICY
+#define FSMOS_SCHED_POLICY SCHED_EDF  ///< Initial scheduling policy, see SchedulingPolicy
+#endif
+
+#ifndef FSMOS_MAX_TOPICS
+#define FSMOS_MAX_TOPICS 16  ///< Topic IDs must be below this value (sizes each task's subscription bitmap)
+#endif
+
+#ifndef FSMOS_MAX_SUBSCRIPTIONS
+#define FSMOS_MAX_SUBSCRIPTIONS 24  ///< Entries in the scheduler's topic->subscriber index
+#endif
+static_assert(FSMOS_MAX_SUBSCRIPTIONS <= 255, "FSMOS_MAX_SUBSCRIPTIONS must fit in uint8_t");
+
+#ifndef FSMOS_TASK_QUEUE_SIZE
+#define FSMOS_TASK_QUEUE_SIZE 4  ///< Per-task mailbox capacity (0 = unbounded heap-backed LinkedQueue)
+#endif
+
+#ifndef FSMOS_TASK_QUEUE_OVERFLOW_POLICY
+#define FSMOS_TASK_QUEUE_OVERFLOW_POLICY QUEUE_DROP_OLDEST  ///< What a full task mailbox does with a new message
+#endif
+
+#ifndef FSMOS_DELIVERY_BUDGET_MSGS
+#define FSMOS_DELIVERY_BUDGET_MSGS 8  ///< Max messages deliver() handles per loop_once() (0 = until the bus is empty)
+#endif
+
+#ifndef FSMOS_DELIVERY_BUDGET_US
+#define FSMOS_DELIVERY_BUDGET_US 0  ///< Max microseconds deliver() spends per loop_once() (0 = no time limit)
+#endif
+
+#ifndef FSMOS_IDLE_SLEEP
+#define FSMOS_IDLE_SLEEP 1  ///< Idle the CPU in loop_once() when no task or message is due (0 = busy spin)
+#endif
+
+#ifndef FSMOS_PIN_CHANGE_INPUT
+#define FSMOS_PIN_CHANGE_INPUT 0  ///< Build PinChangeInput, which claims the PCINT0..2 vectors (0 = off)
+#endif
+
+#ifndef FSMOS_PIN_CHANGE_QUEUE_SIZE
+#define FSMOS_PIN_CHANGE_QUEUE_SIZE 8  ///< Edges PinChangeInput can hold between two loop_once() calls
+#endif
+
+#ifndef FSMOS_STATS_BUCKETS
+#define FSMOS_STATS_BUCKETS 0  ///< Buckets in each per-task exec time and lateness histogram (0 = no histograms)
+#endif
+static_assert(FSMOS_STATS_BUCKETS <= 12, "FSMOS_STATS_BUCKETS must be 12 or less");
+
+#ifndef FSMOS_STACK_MONITOR
+#define FSMOS_STACK_MONITOR 0  ///< Measure each task's stack high-water mark around step()/on_msg() (AVR only; 0 = off)
+#endif
+
+// The per-call scan walks down from the caller's stack pointer and stops
+// at this many paint bytes in a row. A frame that leaves a longer run
+// unwritten (e.g. a large, partly used local buffer) hides what lies
+// below it, so the peak is then under-reported.
+#ifndef FSMOS_STACK_SCAN_SLACK
+#define FSMOS_STACK_SCAN_SLACK 32  ///< Paint bytes in a row that end a stack scan (FSMOS_STACK_MONITOR)
+#endif
+
+#ifndef FSMOS_TRACE_SIZE
+#define FSMOS_TRACE_SIZE 0  ///< Scheduler events kept in the flight recorder, a power of two (0 = off)
+#endif
+static_assert((FSMOS_TRACE_SIZE & (FSMOS_TRACE_SIZE - 1)) == 0 && FSMOS_TRACE_SIZE <= 128,
+              "FSMOS_TRACE_SIZE must be 0 or a power of two up to 128");
+
+#ifndef FSMOS_TOPIC_STATS
+#define FSMOS_TOPIC_STATS 0  ///< Keep per-topic traffic and bus latency counters, see get_topic_stats() (0 = off)
+#endif
+
+#ifndef FSMOS_LOG_BUFFER_SIZE
+#define FSMOS_LOG_BUFFER_SIZE 0  ///< Bytes of RAM holding log lines until the UART has room, a power of two (0 = write at once)
+#endif
+static_assert((FSMOS_LOG_BUFFER_SIZE & (FSMOS_LOG_BUFFER_SIZE - 1)) == 0 && FSMOS_LOG_BUFFER_SIZE <= 128,
+              "FSMOS_LOG_BUFFER_SIZE must be 0 or a power of two up to 128");
+
 /* Message/Event for inter-task communication with reference counting */
 /**
  * @brief Message data structure for inter-task communication
@@ -50,16 +196,135 @@ class Scheduler;
  */
 struct __attribute__((packed)) MsgData {
   uint8_t type;         ///< User-defined event type
-  uint8_t src_id;       ///< Scheduler-assigned ID of the source task
+  uint8_t src_id;       ///< Scheduler-assigned ID of the source task (FSMOS_NO_TASK if none)
   uint8_t topic;        ///< Topic ID (0=direct message, 1-255=pub/sub topics)
-  uint8_t ref_count: 7; ///< Number of tasks to process message (max 127)
+  uint8_t ref_count: 7; ///< Number of live SharedMsg references (max 127)
   bool is_dynamic: 1;   ///< Whether ptr points to dynamically allocated data
   uint16_t arg;         ///< Small payload
   void* ptr;            ///< Optional pointer to larger data
   uint16_t dynamic_size;///< Size of dynamically allocated data
+  uint8_t count;        ///< Posts merged into this message (1 unless the topic uses COALESCE_COUNT)
+#if FSMOS_TOPIC_STATS
+  uint32_t post_us;     ///< micros() when the message was queued on the bus
+#endif
+#if FSMOS_MSG_INLINE_SIZE > 0
+  uint8_t payload[FSMOS_MSG_INLINE_SIZE]; ///< Small inline payload, see get_payload()
+#endif
   
   /** @brief Initialize an empty message */
-  MsgData() : type(0), src_id(0), topic(0), ref_count(0), is_dynamic(0), arg(0), ptr(nullptr) {}
+  MsgData() : type(0), src_id(0), topic(0), ref_count(0), is_dynamic(0), arg(0), ptr(nullptr), dynamic_size(0), count(1) {
+#if FSMOS_MSG_INLINE_SIZE > 0
+    memset(payload, 0, sizeof(payload));
+#endif
+  }
+
+#if FSMOS_MSG_INLINE_SIZE > 0
+  /**
+   * @brief Store a small value in the inline payload
+   * @param value Trivially copyable value of at most FSMOS_MSG_INLINE_SIZE bytes
+   */
+  template<typename T>
+  void set_payload(const T& value) {
+    static_assert(sizeof(T) <= FSMOS_MSG_INLINE_SIZE, "Payload larger than FSMOS_MSG_INLINE_SIZE");
+    memcpy(payload, &value, sizeof(T));
+  }
+
+  /**
+   * @brief Read the inline payload as a value of type T
+   * @return Copy of the payload (the sender must have stored a T)
+   */
+  template<typename T>
+  T get_payload() const {
+    static_assert(sizeof(T) <= FSMOS_MSG_INLINE_SIZE, "Payload larger than FSMOS_MSG_INLINE_SIZE");
+    T value;
+    memcpy(&value, payload, sizeof(T));
+    return value;
+  }
+#endif
+};
+
+/** @brief Handle of a delayed message, used to cancel it */
+typedef uint16_t TimerHandle;
+
+/** @brief Returned when a delayed message could not be scheduled */
+const TimerHandle TIMER_NONE = 0;
+
+/* ================== Message Pool ================== */
+/**
+ * @brief Message pool usage statistics
+ */
+struct __attribute__((packed)) MsgPoolStats {
+  uint8_t capacity;     ///< Number of slots in the pool
+  uint8_t in_use;       ///< Slots currently holding a live message
+  uint8_t high_water;   ///< Highest number of slots ever in use at once
+  uint16_t exhausted;   ///< Allocations refused because the pool was empty
+};
+
+/**
+ * @brief Fixed-capacity slab allocator for MsgData
+ * 
+ * Replaces the per-message new/delete on the post() path with a
+ * statically sized array of slots. Free slots are chained through
+ * their ptr field, so the free list costs no extra RAM.
+ */
+class MsgPool {
+  MsgData slots[FSMOS_MSG_POOL_SIZE];
+  MsgData* free_head;
+  uint8_t in_use;
+  uint8_t high_water;
+  uint16_t exhausted;
+
+public:
+  MsgPool() : free_head(nullptr), in_use(0), high_water(0), exhausted(0) {
+    for (uint8_t i = 0; i < FSMOS_MSG_POOL_SIZE; i++) {
+      slots[i].ptr = free_head;
+      free_head = &slots[i];
+    }
+  }
+
+  MsgPool(const MsgPool&) = delete;
+  MsgPool& operator=(const MsgPool&) = delete;
+
+  /**
+   * @brief Take a cleared message from the pool
+   * @return Pointer to the message or nullptr if the pool is exhausted
+   */
+  MsgData* alloc() {
+    MsgData* m = nullptr;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      if (free_head) {
+        m = free_head;
+        free_head = static_cast<MsgData*>(m->ptr);
+        in_use++;
+        if (in_use > high_water) high_water = in_use;
+      } else if (exhausted < 0xFFFF) {
+        exhausted++;
+      }
+    }
+    if (m) *m = MsgData();
+    return m;
+  }
+
+  /**
+   * @brief Return a message to the pool
+   * @param m Message previously obtained from alloc()
+   */
+  void free(MsgData* m) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      m->ptr = free_head;
+      free_head = m;
+      in_use--;
+    }
+  }
+
+  void get_stats(MsgPoolStats& stats) const {
+    stats.capacity = FSMOS_MSG_POOL_SIZE;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      stats.in_use = in_use;
+      stats.high_water = high_water;
+      stats.exhausted = exhausted;
+    }
+  }
 };
 
 // Smart pointer-like class for message reference counting
@@ -94,22 +359,8 @@ public:
   
   ~SharedMsg() { release(); }
   
-  void release() {
-    if (data) {
-      bool should_delete = false;
-      ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        data->ref_count--;
-        should_delete = (data->ref_count == 0);
-      }
-      if (should_delete) {
-        if (data->is_dynamic && data->ptr) {
-          delete[] static_cast<uint8_t*>(data->ptr);
-        }
-        delete data;
-      }
-      data = nullptr;
-    }
-  }
+  /** @brief Drop this reference; the last one returns the message to the pool */
+  void release();
   
   MsgData* get() const { return data; }
   MsgData* operator->() const { return data; }
@@ -131,9 +382,11 @@ private:
   Node* head;
   Node* tail;
   volatile uint8_t count;
+  uint8_t high_water_mark;
+  uint16_t drop_count;
 
 public:
-  LinkedQueue() : head(nullptr), tail(nullptr), count(0) {}
+  LinkedQueue() : head(nullptr), tail(nullptr), count(0), high_water_mark(0), drop_count(0) {}
 
   ~LinkedQueue() {
     while (head) {
@@ -145,7 +398,8 @@ public:
 
   // Move constructor
   LinkedQueue(LinkedQueue&& other) noexcept 
-    : head(other.head), tail(other.tail), count(other.count) {
+    : head(other.head), tail(other.tail), count(other.count),
+      high_water_mark(other.high_water_mark), drop_count(other.drop_count) {
     other.head = nullptr;
     other.tail = nullptr;
     other.count = 0;
@@ -157,11 +411,15 @@ public:
 
   inline bool push(const T& v) {
     Node* new_node = new Node(v);
-    if (!new_node) return false;
+    if (!new_node) {
+      if (drop_count < 0xFFFF) drop_count++;
+      return false;
+    }
     ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
       if (!head) { head = tail = new_node; }
       else { tail->next = new_node; tail = new_node; }
       count++;
+      if (count > high_water_mark) high_water_mark = count;
     }
     return true;
   }
@@ -189,6 +447,203 @@ public:
   }
 
   inline uint8_t size() const { return count; }
+  inline uint8_t high_water() const { return high_water_mark; }
+  inline uint16_t dropped() const { return drop_count; }
+
+  // Newest queued element for which match(element) is true, or nullptr.
+  // Not interrupt-safe: call only from the context that pops.
+  template<typename Match>
+  T* find_last(Match match) {
+    T* found = nullptr;
+    for (Node* n = head; n; n = n->next) {
+      if (match(n->data)) found = &n->data;
+    }
+    return found;
+  }
+};
+
+/** @brief What a full RingQueue does with a new element */
+enum QueueOverflowPolicy : uint8_t {
+  QUEUE_REJECT = 0,   ///< Refuse the new element, push() returns false
+  QUEUE_DROP_OLDEST   ///< Discard the oldest element to make room
+};
+
+/*
+ * Allocation-free, interrupt-safe ring queue with compile-time capacity.
+ * Drop-in replacement for LinkedQueue (same push/pop/empty/size API).
+ */
+template<typename T, uint8_t N, QueueOverflowPolicy Policy = QUEUE_REJECT>
+class RingQueue {
+  // wrap() takes head + count in 8 bits, which only holds for N <= 128
+  static_assert(N > 0 && N <= 128, "RingQueue capacity must be 1 to 128");
+
+private:
+  T items[N];
+  uint8_t head;
+  volatile uint8_t count;
+  uint8_t high_water_mark;
+  uint16_t drop_count;
+
+  static inline uint8_t wrap(uint8_t i) { return i >= N ? i - N : i; }
+
+public:
+  RingQueue() : head(0), count(0), high_water_mark(0), drop_count(0) {}
+
+  RingQueue(const RingQueue&) = delete;
+  RingQueue& operator=(const RingQueue&) = delete;
+
+  inline bool push(const T& v) {
+    T evicted;  // Released after the atomic section ends
+    bool result = true;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      if (count == N) {
+        if (drop_count < 0xFFFF) drop_count++;
+        if (Policy == QUEUE_DROP_OLDEST) {
+          evicted = items[head];
+          head = wrap(head + 1);
+          count--;
+        } else {
+          result = false;
+        }
+      }
+      if (result) {
+        items[wrap(head + count)] = v;
+        count++;
+        if (count > high_water_mark) high_water_mark = count;
+      }
+    }
+    return result;
+  }
+
+  inline bool pop(T& out) {
+    bool result = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      if (count) {
+        out = items[head];
+        items[head] = T();
+        head = wrap(head + 1);
+        count--;
+        result = true;
+      }
+    }
+    return result;
+  }
+
+  inline bool empty() const { return count == 0; }
+  inline uint8_t size() const { return count; }
+  inline uint8_t capacity() const { return N; }
+  inline uint8_t high_water() const { return high_water_mark; }
+  inline uint16_t dropped() const { return drop_count; }
+
+  // Newest queued element for which match(element) is true, or nullptr.
+  // Not interrupt-safe: call only from the context that pops.
+  template<typename Match>
+  T* find_last(Match match) {
+    for (uint8_t i = count; i > 0; i--) {
+      T& item = items[wrap(head + i - 1)];
+      if (match(item)) return &item;
+    }
+    return nullptr;
+  }
+};
+
+/* Queue types used by the scheduler, selected at compile time */
+#if FSMOS_BUS_QUEUE_SIZE > 0
+typedef RingQueue<SharedMsg, FSMOS_BUS_QUEUE_SIZE, FSMOS_BUS_OVERFLOW_POLICY> BusQueue;
+#else
+typedef LinkedQueue<SharedMsg> BusQueue;
+#endif
+
+#if FSMOS_TASK_QUEUE_SIZE > 0
+typedef RingQueue<SharedMsg, FSMOS_TASK_QUEUE_SIZE, FSMOS_TASK_QUEUE_OVERFLOW_POLICY> TaskQueue;
+#else
+typedef LinkedQueue<SharedMsg> TaskQueue;
+#endif
+
+/* ================== Interrupt Event Queues ================== */
+/**
+ * @brief Event posted from an interrupt handler
+ * 
+ * Fields match Scheduler::post(): src_id is the destination task for
+ * direct messages (topic 0). time_us is delivered as the message payload
+ * when FSMOS_MSG_INLINE_SIZE has room for it.
+ */
+struct __attribute__((packed)) IsrEvent {
+  uint8_t type;
+  uint8_t src_id;
+  uint8_t topic;
+  uint16_t arg;
+  uint32_t time_us;  ///< micros() when the interrupt posted the event
+};
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring for one interrupt source
+ * 
+ * The interrupt handler is the only writer of tail and the scheduler the
+ * only writer of head. Both are single bytes published with release/acquire
+ * ordering, so neither side allocates or disables interrupts. Declare an
+ * IsrQueue<N> for the storage and register it with OS.add_isr_source().
+ */
+class IsrSource {
+public:
+  IsrSource(const IsrSource&) = delete;
+  IsrSource& operator=(const IsrSource&) = delete;
+
+  /** @brief Producer side: queue an event, false (and counted) if the ring is full */
+  inline bool push(const IsrEvent& e) {
+    uint8_t t = tail;
+    if ((uint8_t)(t - __atomic_load_n(&head, __ATOMIC_ACQUIRE)) > mask) {
+      if (drop_count < 0xFF) drop_count++;
+      return false;
+    }
+    items[t & mask] = e;
+    __atomic_store_n(&tail, (uint8_t)(t + 1), __ATOMIC_RELEASE);
+    return true;
+  }
+
+  /** @brief Consumer side: take the oldest event */
+  inline bool pop(IsrEvent& out) {
+    uint8_t h = head;
+    if (h == __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) return false;
+    out = items[h & mask];
+    __atomic_store_n(&head, (uint8_t)(h + 1), __ATOMIC_RELEASE);
+    return true;
+  }
+
+  inline uint8_t size() const {
+    return (uint8_t)(__atomic_load_n(&tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&head, __ATOMIC_ACQUIRE));
+  }
+  inline bool empty() const { return size() == 0; }
+  inline uint8_t capacity() const { return mask + 1; }
+  /** @brief Events lost because the ring was full (saturates at 255) */
+  inline uint8_t dropped() const { return drop_count; }
+
+protected:
+  IsrSource(IsrEvent* storage, uint8_t capacity)
+    : items(storage), mask(capacity - 1), head(0), tail(0), drop_count(0), next(nullptr) {}
+
+private:
+  friend class Scheduler;
+
+  IsrEvent* const items;
+  const uint8_t mask;
+  uint8_t head;        // Written by the scheduler only
+  uint8_t tail;        // Written by the interrupt handler only
+  uint8_t drop_count;  // Written by the interrupt handler only
+  IsrSource* next;     // Scheduler's list of registered sources
+};
+
+/**
+ * @brief IsrSource with storage for N events
+ * @tparam N Capacity, a power of two up to 128
+ */
+template<uint8_t N>
+class IsrQueue : public IsrSource {
+  static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "IsrQueue capacity must be a power of two up to 128");
+  IsrEvent storage[N];
+
+public:
+  IsrQueue() : IsrSource(storage, N) {}
 };
 
 /* ================== Profiling & Reset Info ================== */
@@ -196,14 +651,30 @@ public:
  * @brief Task execution statistics
  * 
  * Tracks performance metrics for individual tasks including:
- * - Maximum execution time
- * - Total execution time
+ * - Maximum and total execution time
  * - Number of executions
+ * - Start lateness (how long after next_due step() began) and missed deadlines
+ * - With FSMOS_STATS_BUCKETS > 0, histograms of exec time and lateness
+ * 
+ * Histogram bucket 0 holds values below 1 << shift, and bucket b holds
+ * values below (1 << shift) << 2b, so each bucket covers four times the
+ * range of the one before; the last bucket takes everything above. Exec
+ * time uses Scheduler::EXEC_HIST_SHIFT (bucket 0 is < 32 us), lateness
+ * uses Scheduler::LATE_HIST_SHIFT (bucket 0 is on time).
+ * 
+ * Counters saturate instead of wrapping; Scheduler::reset_task_stats()
+ * starts a new window.
  */
 struct __attribute__((packed)) TaskStats {
   uint32_t max_exec_time_us = 0;    ///< Longest single execution time
   uint32_t total_exec_time_us = 0;  ///< Total execution time
-  uint16_t run_count = 0;           ///< Number of times task has run
+  uint32_t run_count = 0;           ///< Number of times task has run
+  uint16_t max_lateness_ms = 0;     ///< Latest start after next_due
+  uint16_t missed_deadlines = 0;    ///< Periodic runs that started a full period or more late
+#if FSMOS_STATS_BUCKETS > 0
+  uint16_t exec_hist[FSMOS_STATS_BUCKETS] = {};  ///< Runs per exec time bucket
+  uint16_t late_hist[FSMOS_STATS_BUCKETS] = {};  ///< Runs per start lateness bucket
+#endif
 };
 
 /**
@@ -218,14 +689,132 @@ struct __attribute__((packed)) TaskStats {
 struct ResetInfo {
   uint8_t last_task_id;  ///< ID of task running during reset
   uint8_t reset_reason;   ///< MCU status register value at reset
+  uint8_t trace_count;    ///< Flight recorder events kept from before the reset, see get_trace_record()
+};
+
+/**
+ * @brief Kind of a flight recorder event
+ */
+enum TraceEvent : uint8_t {
+  TRACE_NONE = 0,
+  TRACE_TASK_START = 1,   ///< id = task ID, step() begins
+  TRACE_TASK_END = 2,     ///< id = task ID, step() returned
+  TRACE_MSG_POST = 3,     ///< id = message type, arg = topic; queued on the bus
+  TRACE_MSG_DELIVER = 4,  ///< id = message type, arg = receiving task; on_msg() begins
+  TRACE_LOG = 5,          ///< id/arg = low/high byte of the log message's flash address
+  TRACE_MSG_TELL = 6      ///< id = message type, arg = destination task; direct message queued on the bus
+};
+
+/**
+ * @brief One flight recorder event (FSMOS_TRACE_SIZE)
+ * 
+ * The timestamp is millis() modulo 8192, so the gap between two
+ * consecutive events is exact as long as it is under 8 seconds.
+ */
+struct __attribute__((packed)) TraceRecord {
+  uint16_t stamp;  ///< TraceEvent in the top 3 bits, millis() & 0x1FFF below
+  uint8_t id;
+  uint8_t arg;
+
+  TraceEvent event() const { return (TraceEvent)(stamp >> 13); }
+  uint16_t time_ms() const { return stamp & 0x1FFF; }
 };
 
 /* ================== Memory Monitoring ================== */
+/**
+ * @brief Global message bus statistics
+ */
+struct __attribute__((packed)) BusStats {
+  uint8_t pending;      ///< Messages currently waiting for delivery
+  uint8_t high_water;   ///< Deepest the bus queue has been
+  uint16_t dropped;     ///< Messages lost because the bus queue was full
+  uint16_t merged;      ///< Posts folded into a pending message by a coalescing policy
+  uint16_t deferred;    ///< Messages left for the next loop_once() because the delivery budget ran out
+  uint16_t discarded;   ///< Messages not delivered because the task was suspended and does not queue
+};
+
+/**
+ * @brief Statistics of one task's mailbox
+ * 
+ * The mailbox holds messages for a suspended task (and any that arrive
+ * before its backlog is drained after activate()).
+ */
+struct __attribute__((packed)) MailboxStats {
+  uint8_t pending;      ///< Messages waiting in the mailbox
+  uint8_t capacity;     ///< Mailbox capacity (0 = unbounded)
+  uint8_t high_water;   ///< Deepest the mailbox has been
+  uint16_t dropped;     ///< Messages lost because the mailbox was full
+};
+
+/**
+ * @brief Traffic and bus latency of one topic (FSMOS_TOPIC_STATS)
+ * 
+ * Topic 0 covers direct messages. Latency is the time a message waited
+ * on the bus between post() and deliver(); bus_us is the time deliver()
+ * spent handing it to its recipients, including their on_msg(). Mean
+ * latency is total_latency_us / delivered, mean fan-out is
+ * recipients / delivered. All counters saturate.
+ */
+struct __attribute__((packed)) TopicStats {
+  uint16_t posted;            ///< Posts accepted, including ones merged into a pending message
+  uint16_t dropped;           ///< Posts lost: message pool or bus full, or nobody to deliver to
+  uint16_t delivered;         ///< Messages taken off the bus
+  uint16_t recipients;        ///< Tasks the messages were handed to (on_msg() or mailbox)
+  uint16_t max_latency_us;    ///< Longest wait on the bus
+  uint32_t total_latency_us;  ///< Sum of the waits on the bus
+  uint32_t bus_us;            ///< Time spent delivering the topic's messages
+};
+
+/**
+ * @brief How post() treats a topic message while an earlier one is pending
+ * 
+ * Only messages still waiting on the bus are merged; once delivered,
+ * the next post is queued normally.
+ */
+enum CoalescePolicy : uint8_t {
+  COALESCE_NONE = 0,       ///< Queue every message
+  COALESCE_LATEST = 1,     ///< Overwrite the pending message on the topic (any type) with the new one
+  COALESCE_DROP_IDENTICAL = 2, ///< Drop the new message if the newest pending one on the topic has the same type, arg and ptr
+  COALESCE_COUNT = 3       ///< Bump MsgData::count of the newest pending message on the topic if it has the same type
+};
+
+/**
+ * @brief CPU idle time statistics
+ */
+struct __attribute__((packed)) IdleStats {
+  uint32_t idle_ms;     ///< Time spent idling since the window started
+  uint32_t window_ms;   ///< Length of the measurement window
+  uint8_t idle_percent; ///< idle_ms as a percentage of window_ms
+};
+
+/**
+ * @brief Log buffer usage (FSMOS_LOG_BUFFER_SIZE)
+ */
+struct LogStats {
+  uint8_t pending;     ///< Bytes waiting to be written to Serial
+  uint8_t high_water;  ///< Most bytes ever waiting
+  uint16_t dropped;    ///< Log lines lost because the buffer was full (saturating)
+  uint16_t truncated;  ///< Lines cut short to fit the buffer, marked with a trailing '~' (saturating)
+};
+
+/**
+ * @brief Idle hook called by loop_once() when nothing is due
+ * 
+ * The hook may return early (e.g. on an interrupt) but should not block
+ * longer than max_idle_ms. Host builds can use it to advance a virtual clock.
+ */
+typedef void (*IdleHook)(uint32_t max_idle_ms);
+
 struct __attribute__((packed)) TaskMemoryInfo {
   uint16_t task_struct_size;      // Size of task object
   uint16_t subscription_size;      // Size of subscription array
   uint16_t queue_size;            // Size of message queue
   uint16_t total_allocated;       // Total memory allocated by task
+  uint16_t stack_peak;            // Most stack one step()/on_msg() call used below the scheduler's frame (0 = not measured)
+  uint16_t stack_headroom;        // Bytes left between the heap and the deepest point the task reached
+  uint16_t heap_allocs;           // operator new calls made while the task ran, since begin() or reset_task_stats()
+  uint16_t heap_bytes;            // Heap bytes those calls took (0 = not measured)
+  uint16_t allocs_per_min;        // heap_allocs averaged over the same window
 };
 
 /**
@@ -250,7 +839,7 @@ struct __attribute__((packed)) SystemMemoryInfo {
   
   // Task Memory
   uint8_t total_tasks;        ///< Number of active tasks
-  uint16_t task_memory;       ///< Total memory used by task objects
+  uint16_t task_memory;       ///< task_count * sizeof(Task), without subclass members
   
   // Message Memory
   uint8_t active_messages;    ///< Number of pending messages
@@ -266,6 +855,45 @@ struct __attribute__((packed)) SystemMemoryInfo {
   uint32_t flash_free;        ///< Available flash memory
 };
 
+/**
+ * @brief State of the heap at one point in time
+ * 
+ * Taken by Scheduler::get_heap_snapshot() from avr-libc's free list.
+ * Comparing two snapshots with diff() shows whether new/delete traffic
+ * is growing the heap or leaving it fragmented.
+ */
+struct __attribute__((packed)) HeapSnapshot {
+  uint16_t heap_size;        ///< Bytes between __heap_start and the heap's top (__brkval)
+  uint16_t free_list_bytes;  ///< Usable bytes in freed chunks below the top
+  uint8_t free_blocks;       ///< Freed chunks on the free list (fragments)
+  uint16_t largest_free;     ///< Largest freed chunk (0 if the free list is empty)
+  uint16_t unallocated;      ///< Bytes between the heap's top and the stack
+
+  /** @brief Field-by-field change between two snapshots */
+  struct Delta {
+    int16_t heap_size;
+    int16_t free_list_bytes;
+    int8_t free_blocks;
+    int16_t largest_free;
+    int16_t unallocated;
+  };
+
+  /**
+   * @brief Change from an earlier snapshot to this one
+   * @param earlier Snapshot taken before this one
+   * @return This snapshot minus earlier
+   */
+  Delta diff(const HeapSnapshot& earlier) const {
+    Delta d;
+    d.heap_size = (int16_t)(heap_size - earlier.heap_size);
+    d.free_list_bytes = (int16_t)(free_list_bytes - earlier.free_list_bytes);
+    d.free_blocks = (int8_t)(free_blocks - earlier.free_blocks);
+    d.largest_free = (int16_t)(largest_free - earlier.largest_free);
+    d.unallocated = (int16_t)(unallocated - earlier.unallocated);
+    return d;
+  }
+};
+
 /* ================== Logging ================== */
 /**
  * @brief Log message severity levels
@@ -282,16 +910,21 @@ enum LogLevel : uint8_t {
 };
 
 #ifndef FSMOS_LOG_LEVEL
-#define FSMOS_LOG_LEVEL LOG_INFO
+#define FSMOS_LOG_LEVEL LOG_INFO  ///< Lowest level compiled in; log calls below it compile to nothing
+#endif
+
+#ifndef FSMOS_TASK_LOG_LEVEL
+#define FSMOS_TASK_LOG_LEVEL FSMOS_LOG_LEVEL  ///< Level tasks start with, see Task::set_log_level()
 #endif
 
 /* ================== Logging convenience macros (printf-style) ================== */
-// Use inside Task methods. These call OS.logFormatted with PROGMEM format strings.
+// Use inside Task methods. These call OS.logFormatted with PROGMEM format strings
+// if the level is enabled for the task; otherwise the arguments are not evaluated.
 #ifndef FSMOS_DISABLE_LOGGING
-#define log_debugf(fmt, ...)   OS.logFormatted(this, LOG_DEBUG,   fmt, ##__VA_ARGS__)
-#define log_infof(fmt, ...)    OS.logFormatted(this, LOG_INFO,    fmt, ##__VA_ARGS__)
-#define log_warnf(fmt, ...)    OS.logFormatted(this, LOG_WARNING, fmt, ##__VA_ARGS__)
-#define log_errorf(fmt, ...)   OS.logFormatted(this, LOG_ERROR,   fmt, ##__VA_ARGS__)
+#define log_debugf(fmt, ...)   do { if (log_enabled(LOG_DEBUG))   OS.logFormatted(this, LOG_DEBUG,   fmt, ##__VA_ARGS__); } while (0)
+#define log_infof(fmt, ...)    do { if (log_enabled(LOG_INFO))    OS.logFormatted(this, LOG_INFO,    fmt, ##__VA_ARGS__); } while (0)
+#define log_warnf(fmt, ...)    do { if (log_enabled(LOG_WARNING)) OS.logFormatted(this, LOG_WARNING, fmt, ##__VA_ARGS__); } while (0)
+#define log_errorf(fmt, ...)   do { if (log_enabled(LOG_ERROR))   OS.logFormatted(this, LOG_ERROR,   fmt, ##__VA_ARGS__); } while (0)
 #else
 #define log_debugf(fmt, ...)
 #define log_infof(fmt, ...)
@@ -300,18 +933,39 @@ enum LogLevel : uint8_t {
 #endif
 
 /* ================== Task Node ================== */
+/**
+ * @brief Scheduler bookkeeping for one task
+ * 
+ * Embedded in every Task, so registering a task never allocates.
+ */
 struct TaskNode {
+    static const uint8_t NOT_QUEUED = 0xFF;
+
     Task* task;
     TaskStats stats;
     TaskNode* next;
     uint8_t id;
+    uint8_t heap_pos;  ///< Index in the scheduler's run queue (NOT_QUEUED if not waiting to run)
+    uint16_t last_dispatch;  ///< Dispatch sequence number of the last step(), for round-robin
+#if FSMOS_STACK_MONITOR
+    uint16_t stack_peak;  ///< Most stack a step()/on_msg() call used, from the SP before the call
+    uint16_t stack_low;   ///< Lowest address those calls reached (0xFFFF = none yet)
+#endif
+#if !defined(FSMOS_DISABLE_LEAK_DETECTION)
+    uint16_t heap_allocs;  ///< operator new calls charged to the task (saturating)
+    uint16_t heap_bytes;   ///< Heap bytes they took (saturating)
+#endif
+    uint8_t owned:1;   ///< Added with add(): the scheduler deletes the task once it terminates
 
-    TaskNode(Task* t, uint8_t task_id) 
-        : task(t), next(nullptr), id(task_id) {
-         stats.max_exec_time_us = 0;
-         stats.total_exec_time_us = 0;
-         stats.run_count = 0;
-    }
+    TaskNode() 
+        : task(nullptr), next(nullptr), id(FSMOS_NO_TASK), heap_pos(NOT_QUEUED), last_dispatch(0),
+#if FSMOS_STACK_MONITOR
+          stack_peak(0), stack_low(0xFFFF),
+#endif
+#if !defined(FSMOS_DISABLE_LEAK_DETECTION)
+          heap_allocs(0), heap_bytes(0),
+#endif
+          owned(0) {}
 };
 
 /* ================== Scheduler ================== */
@@ -342,13 +996,33 @@ public:
 
     /**
      * @brief Add a new task to the scheduler
+     * 
+     * The scheduler takes ownership: a task allocated with new is deleted
+     * once it terminates. Use add_static() for tasks that live forever.
+     * 
      * @param t Pointer to the task to add
-     * @return Task ID (255 if failed)
+     * @return Task ID (FSMOS_NO_TASK if failed, e.g. FSMOS_MAX_TASKS reached)
      */
     uint8_t add(Task* t);
 
+    /**
+     * @brief Add a statically allocated task to the scheduler
+     * 
+     * For global tasks that exist for the whole program. The task is never
+     * deleted; if it terminates, it is only unregistered (on_terminate()
+     * still runs) and may be added again.
+     * 
+     * @param t Reference to the task to add
+     * @return Task ID (FSMOS_NO_TASK if failed, e.g. FSMOS_MAX_TASKS reached)
+     */
+    uint8_t add_static(Task& t);
+
     /**
      * @brief Remove a task from the scheduler
+     * 
+     * Only unregisters the task; it is not deleted. Messages waiting in
+     * its mailbox are released.
+     * 
      * @param task_id ID of the task to remove
      * @return true if task was found and removed
      */
@@ -362,10 +1036,13 @@ public:
      * @param arg Optional 16-bit payload
      * @param ptr Optional pointer to larger data
      * @param is_dynamic Whether ptr is dynamically allocated
+     * @param payload Optional bytes copied into MsgData::payload
+     * @param payload_size Number of payload bytes (at most FSMOS_MSG_INLINE_SIZE)
      * @return true if message was queued successfully
      */
     bool post(uint8_t type, uint8_t src_id, uint8_t topic, 
-              uint16_t arg = 0, void* ptr = nullptr, bool is_dynamic = false);
+              uint16_t arg = 0, void* ptr = nullptr, bool is_dynamic = false,
+              const void* payload = nullptr, uint8_t payload_size = 0);
 
     /**
      * @brief Execute one iteration of the scheduler
@@ -385,6 +1062,17 @@ public:
      */
     uint32_t now() const { return ms; }
 
+    /**
+     * @brief Get the time at which the scheduler next has work to do
+     * 
+     * Returns now() if messages are waiting for delivery, otherwise the
+     * earlier of the next task's next_due and the next delayed message.
+     * If nothing is scheduled, returns a time INT32_MAX ms in the future.
+     * 
+     * @return Absolute time in milliseconds (compare with wrap-safe math)
+     */
+    uint32_t next_wakeup() const;
+
     /**
      * @brief Enable the watchdog timer
      * @param timeout Watchdog timeout period
@@ -392,14 +1080,16 @@ public:
     void enable_watchdog(uint8_t timeout = WDTO_1S);
 
     /**
-     * @brief Enable stack usage monitoring
-     * Installs stack canaries for overflow detection
+     * @brief Start a new stack measurement window
+     * 
+     * The unused stack is painted at boot; this repaints it and clears
+     * the global and per-task high-water marks (FSMOS_STACK_MONITOR).
      */
     void enable_stack_monitoring();
 
     /**
-     * @brief Get remaining free stack space
-     * @return Number of free bytes in stack
+     * @brief Get the least free stack seen since boot or enable_stack_monitoring()
+     * @return Bytes that were never used between the heap and the stack
      */
     int get_free_stack() const;
 
@@ -411,6 +1101,25 @@ public:
      */
     bool get_task_stats(uint8_t task_id, TaskStats& stats) const;
 
+    /**
+     * @brief Clear every task's statistics and start a new idle window
+     * 
+     * Task and idle statistics then cover the same window, see
+     * IdleStats::window_ms.
+     */
+    void reset_task_stats();
+
+    static const uint8_t EXEC_HIST_SHIFT = 5;  ///< Exec time bucket 0 is below 32 us
+    static const uint8_t LATE_HIST_SHIFT = 0;  ///< Lateness bucket 0 is 0 ms
+
+    /**
+     * @brief Histogram bucket of a value, see TaskStats
+     * @param value Exec time in us or lateness in ms
+     * @param shift EXEC_HIST_SHIFT or LATE_HIST_SHIFT
+     * @return Bucket index, at most FSMOS_STATS_BUCKETS - 1
+     */
+    static uint8_t stats_bucket(uint32_t value, uint8_t shift);
+
     /**
      * @brief Get total number of active tasks
      * @return Number of tasks in the system
@@ -419,11 +1128,28 @@ public:
 
     /**
      * @brief Get pointer to a task by ID
+     * 
+     * Constant time. IDs carry a generation count, so the ID of a removed
+     * task does not find a new task that reused its slot, until the slot
+     * has been reused as often as FSMOS_TASK_GEN_BITS allows.
+     * 
      * @param task_id ID of the task to find
      * @return Pointer to task or nullptr if not found
      */
     Task* get_task(uint8_t task_id) const;
 
+    /**
+     * @brief Iterate over live tasks
+     * 
+     * Start with cursor = 0 and call repeatedly; the cursor is advanced
+     * past each returned task. Task IDs are not 0..count-1, so use this
+     * (and Task::get_id()) instead of counting.
+     * 
+     * @param cursor Iteration state, 0 to start
+     * @return Next live task, or nullptr when done
+     */
+    Task* next_task(uint8_t& cursor) const;
+
     /**
      * @brief Get information about last system reset
      * @param info Reference to store reset information
@@ -431,10 +1157,48 @@ public:
      */
     bool get_reset_info(ResetInfo& info);
 
+    /**
+     * @brief Read the flight recorder
+     * 
+     * After a watchdog or brown-out reset the recorder is frozen and holds
+     * the events leading up to it (ResetInfo::trace_count of them) until
+     * restart_trace(); otherwise it shows the latest events.
+     * 
+     * @param index 0 for the oldest event
+     * @param record Reference to store the event
+     * @return false if index is past the last event or tracing is off
+     */
+    bool get_trace_record(uint8_t index, TraceRecord& record) const;
+
+    /**
+     * @brief Clear the flight recorder and resume recording
+     */
+    void restart_trace();
+
+    /**
+     * @brief Check whether the flight recorder holds a trace from before a reset
+     */
+    bool is_trace_frozen() const;
+
     // Logging API
     void logMessage(Task* task, LogLevel level, const __FlashStringHelper* message);
     void logFormatted(Task* task, LogLevel level, const __FlashStringHelper* fmt, ...);
 
+    /**
+     * @brief Write every buffered log line now, waiting for the UART
+     * 
+     * For fault handlers and before a deliberate reset, or before printing
+     * to Serial directly so the output does not split a log line. Works
+     * with interrupts disabled. LOG_ERROR lines flush by themselves.
+     */
+    void flush_log();
+
+    /**
+     * @brief Get log buffer usage (all zero without FSMOS_LOG_BUFFER_SIZE)
+     * @param stats Reference to store the figures
+     */
+    void get_log_stats(LogStats& stats) const;
+
     // Diagnostics (public)
     bool get_task_memory_info(uint8_t task_id, TaskMemoryInfo& info) const;
     bool get_system_memory_info(SystemMemoryInfo& info) const;
@@ -443,31 +1207,324 @@ public:
     uint8_t get_heap_fragmentation() const;
     uint8_t count_heap_fragments() const;
 
+    /**
+     * @brief Walk the heap's free list
+     * 
+     * Cost grows with the number of free chunks, not the heap size.
+     * 
+     * @param snapshot Reference to store the heap state
+     */
+    void get_heap_snapshot(HeapSnapshot& snapshot) const;
+
+    /**
+     * @brief Register an interrupt event queue
+     * 
+     * Events queued with post_from_isr() are moved to the message bus at
+     * the start of every loop_once(). Call before enabling the interrupt.
+     * 
+     * @param source Queue that lives as long as the scheduler (e.g. a global)
+     */
+    void add_isr_source(IsrSource& source);
+
+    /**
+     * @brief Post a message from an interrupt handler
+     * 
+     * Only queues a small event in the source's ring: no pool allocation,
+     * no heap and no interrupt masking. One interrupt source (producer)
+     * per queue. The message carries the micros() of the call as payload
+     * (msg.get_payload<uint32_t>()) if FSMOS_MSG_INLINE_SIZE >= 4.
+     * 
+     * @param source Queue registered with add_isr_source()
+     * @param type User-defined message type
+     * @param src_id Source task ID (destination task for direct messages,
+     *               FSMOS_NO_TASK if the event has no source task)
+     * @param topic Topic ID (0 for direct)
+     * @param arg Optional 16-bit payload
+     * @return false if the ring is full (see IsrSource::dropped())
+     */
+    static bool post_from_isr(IsrSource& source, uint8_t type, uint8_t src_id, uint8_t topic, uint16_t arg = 0) {
+      IsrEvent e = { type, src_id, topic, arg, (uint32_t)micros() };
+      return source.push(e);
+    }
+
+    /**
+     * @brief Get usage statistics of the message pool
+     * @param stats Reference to store pool statistics
+     */
+    void get_msg_pool_stats(MsgPoolStats& stats) const { msg_pool.get_stats(stats); }
+
+    /**
+     * @brief Get statistics of the global message bus queue
+     * @param stats Reference to store bus statistics
+     */
+    void get_bus_stats(BusStats& stats) const;
+
+    /**
+     * @brief Get statistics of a task's mailbox
+     * @param task_id ID of the task
+     * @param stats Reference to store mailbox statistics
+     * @return true if the task was found
+     */
+    bool get_mailbox_stats(uint8_t task_id, MailboxStats& stats) const;
+
+#if FSMOS_TOPIC_STATS
+    /**
+     * @brief Get traffic and latency statistics of a topic
+     * @param topic Topic ID (0 = direct messages)
+     * @param stats Reference to store topic statistics
+     * @return false if topic is not below FSMOS_MAX_TOPICS
+     */
+    bool get_topic_stats(uint8_t topic, TopicStats& stats) const;
+
+    /**
+     * @brief Clear the statistics of every topic
+     */
+    void reset_topic_stats();
+#endif
+
+    /**
+     * @brief Limit the work deliver() does in one loop_once()
+     * 
+     * Messages left over stay queued in order and are delivered first in
+     * the next iteration, after due tasks have had their step().
+     * At least one message is always delivered.
+     * 
+     * @param max_msgs Messages per iteration (0 = no count limit)
+     * @param max_us Microseconds per iteration (0 = no time limit)
+     */
+    void set_delivery_budget(uint8_t max_msgs, uint16_t max_us) {
+      delivery_budget_msgs = max_msgs;
+      delivery_budget_us = max_us;
+    }
+
+    /**
+     * @brief Post a message that is delivered at an absolute time
+     * @param when Delivery time in milliseconds (compared wrap-safely with now())
+     * @param type User-defined message type
+     * @param src_id Source task ID (destination for direct messages)
+     * @param topic Topic ID (0 for direct, 1-255 for pub/sub)
+     * @param arg Optional 16-bit payload
+     * @param ptr Optional pointer to larger data
+     * @param is_dynamic Whether ptr is dynamically allocated
+     * @param payload Optional bytes copied into MsgData::payload
+     * @param payload_size Number of payload bytes
+     * @return Handle for cancel_timer(), or TIMER_NONE on failure
+     */
+    TimerHandle post_at(uint32_t when, uint8_t type, uint8_t src_id, uint8_t topic,
+                        uint16_t arg = 0, void* ptr = nullptr, bool is_dynamic = false,
+                        const void* payload = nullptr, uint8_t payload_size = 0);
+
+    /**
+     * @brief Post a message that is delivered after a delay
+     * @param delay_ms Milliseconds from now()
+     * @return Handle for cancel_timer(), or TIMER_NONE on failure
+     * @see post_at()
+     */
+    TimerHandle post_after(uint32_t delay_ms, uint8_t type, uint8_t src_id, uint8_t topic,
+                           uint16_t arg = 0, void* ptr = nullptr, bool is_dynamic = false,
+                           const void* payload = nullptr, uint8_t payload_size = 0) {
+      return post_at(ms + delay_ms, type, src_id, topic, arg, ptr, is_dynamic, payload, payload_size);
+    }
+
+    /**
+     * @brief Cancel a delayed message that has not fired yet
+     * @param handle Handle returned by post_at()/post_after()
+     * @return true if the message was pending and is now discarded
+     */
+    bool cancel_timer(TimerHandle handle);
+
+    /**
+     * @brief Get the number of delayed messages waiting to fire
+     * @return Pending timers (at most FSMOS_MAX_TIMERS)
+     */
+    uint8_t get_pending_timers() const { return timer_count; }
+
+    /**
+     * @brief Set how messages published on a topic are coalesced
+     * @param topic Topic ID (1 to FSMOS_MAX_TOPICS-1)
+     * @param policy Coalescing policy (default COALESCE_NONE)
+     * @return true if the topic is valid
+     */
+    bool set_coalesce_policy(uint8_t topic, CoalescePolicy policy);
+
+    /**
+     * @brief Get the coalescing policy of a topic
+     * @param topic Topic ID
+     * @return Policy set with set_coalesce_policy()
+     */
+    CoalescePolicy get_coalesce_policy(uint8_t topic) const;
+
+    /**
+     * @brief Select the order in which due tasks run
+     * @param p Scheduling policy (default FSMOS_SCHED_POLICY)
+     */
+    void set_policy(SchedulingPolicy p) { policy = p; }
+
+    /**
+     * @brief Get the active scheduling policy
+     * @return Current SchedulingPolicy
+     */
+    SchedulingPolicy get_policy() const { return static_cast<SchedulingPolicy>(policy); }
+
+    /**
+     * @brief Replace the default idle behaviour
+     * 
+     * On AVR the default enters SLEEP_MODE_IDLE until the next interrupt
+     * (timer0 tick, pin change, UART); elsewhere it returns immediately.
+     * 
+     * @param hook Function to call when idle (nullptr restores the default)
+     */
+    void set_idle_hook(IdleHook hook) { idle_hook = hook; }
+
+    /**
+     * @brief Get the time spent idling since begin() or reset_idle_stats()
+     * @param stats Reference to store idle statistics
+     */
+    void get_idle_stats(IdleStats& stats) const;
+
+    /**
+     * @brief Start a new idle measurement window
+     */
+    void reset_idle_stats();
+
     // Message processing
     SharedMsg get_next_message(uint8_t task_id);
     void process_message(SharedMsg& msg);
 
 private:
-    void _print_log_prefix(Task* task, LogLevel level);
+    friend class SharedMsg;
+    friend class Task;
+    friend struct HeapHooks;
+
+    void _print_log_prefix(Print& out, Task* task, LogLevel level, uint32_t t) const;
+    bool log_wanted(Task* task, LogLevel level) const;
+#if FSMOS_LOG_BUFFER_SIZE
+    void queue_log(Task* task, uint8_t flags, const void* payload, uint8_t len);
+    uint8_t log_byte(uint8_t offset) const { return log_buf[(uint8_t)(log_tail + offset) & (FSMOS_LOG_BUFFER_SIZE - 1)]; }
+    void print_log_record(Print& out) const;
+    void pop_log_record();
+    void drain_log();
+    void write_log_backlog();
+#endif
     void deliver();
     TaskNode* find_task_node(uint8_t task_id) const;
+    uint8_t count_subscribers(uint8_t topic) const;
+    void rebuild_topic_index();
+    void unindex_task(TaskNode* node);
+    void reap_terminated();
+    bool coalesce(uint8_t type, uint8_t src_id, uint8_t topic, uint16_t arg, void* ptr, bool is_dynamic,
+                  const void* payload, uint8_t payload_size);
+    uint8_t register_task(Task* t, bool owned);
+    MsgData* make_msg(uint8_t type, uint8_t src_id, uint8_t topic, uint16_t arg, void* ptr, bool is_dynamic,
+                      const void* payload, uint8_t payload_size);
+    bool has_targets(const MsgData* data) const;
+    void fire_timers(uint32_t now);
+    bool enqueue(const SharedMsg& msg);
+    void count_dropped(uint8_t topic);
+#if FSMOS_TOPIC_STATS
+    void record_delivery(const MsgData* data, uint32_t start_us);
+#endif
+    void release_slot(TaskNode* node);
+    void run_task(TaskNode* node);
+    void wake_task(TaskNode* node);
+    void dispatch(TaskNode* node, const SharedMsg& msg);
+    bool budget_spent(uint8_t delivered, uint32_t start_us) const;
+    void drain_mailboxes(uint8_t& delivered, uint32_t start_us);
+    void drain_isr_sources();
+#if FSMOS_STACK_MONITOR && defined(__AVR__)
+    uint16_t begin_stack_probe();
+    void probe_stack(TaskNode* node, uint16_t sp_before);
+#endif
+#if !defined(FSMOS_DISABLE_LEAK_DETECTION)
+    void charge_allocation(uint16_t bytes);
+#endif
+    void idle();
+
+    // Run queue: binary min-heap of active tasks keyed by next_due
+    void schedule_task(Task* t);
+    void unschedule_task(Task* t);
+    void heap_insert(TaskNode* node);
+    void heap_remove(TaskNode* node);
+    void heap_sift_up(uint8_t pos);
+    void heap_sift_down(uint8_t pos);
+    void heap_place(uint8_t pos, TaskNode* node);
+    static bool due_before(const TaskNode* a, const TaskNode* b);
+    bool runs_before(const TaskNode* a, const TaskNode* b) const;
+    void sort_ready();
     
-    LinkedQueue<SharedMsg> message_queue;
+    MsgPool msg_pool;
+    BusQueue message_queue;
+    IsrSource* isr_sources;
     TaskNode* task_list;
     uint8_t task_count;
     volatile uint32_t ms;
     uint8_t watchdog_enabled:1;
-    uint8_t next_task_id;
+    uint8_t topic_index_dirty:1;  // Subscriptions or tasks changed since last rebuild
+    uint8_t topic_index_full:1;   // Last rebuild ran out of slots, fall back to scanning
+    uint8_t reap_pending:1;       // A task was terminated and awaits cleanup
+    uint8_t mailbox_pending:1;    // An active task has messages waiting in its mailbox
+    uint8_t reset_task_id;        // reset_info.last_task_id as begin() found it
+
+    // Slot table for O(1) lookup by ID, with the generation of each slot
+    TaskNode* task_slots[FSMOS_MAX_TASKS];
+    uint8_t slot_generation[FSMOS_MAX_TASKS];
+
+    TaskNode* run_queue[FSMOS_MAX_TASKS];
+    uint8_t run_queue_len;
+    TaskNode* ready[FSMOS_MAX_TASKS];  // Tasks due in the current iteration, in run order
+    uint8_t ready_len;
+    uint8_t policy;
+    uint16_t dispatch_seq;
+
+    IdleHook idle_hook;
+    uint32_t idle_ms;            // Whole milliseconds spent idling
+    uint16_t idle_us_rem;        // Sub-millisecond remainder of idle time
+    uint32_t idle_window_start;
+
+#if FSMOS_STACK_MONITOR && defined(__AVR__)
+    uint16_t stack_low_water;    // Lowest address the stack has reached
+    uint16_t stack_paint_floor;  // Heap end when the stack area was last painted
+#endif
+
+    // Topic->subscriber index: subscribers of topic t are
+    // topic_subscribers[topic_start[t] .. topic_start[t + 1] - 1]
+    TaskNode* topic_subscribers[FSMOS_MAX_SUBSCRIPTIONS];
+    uint8_t topic_start[FSMOS_MAX_TOPICS + 1];
+
+    // Two bits of CoalescePolicy per topic
+    uint8_t topic_coalesce[(FSMOS_MAX_TOPICS + 3) / 4];
+    uint16_t bus_merged;
+    uint16_t bus_deferred;
+    uint16_t bus_discarded;
+#if FSMOS_TOPIC_STATS
+    TopicStats topic_stats[FSMOS_MAX_TOPICS];
+#endif
+
+#if FSMOS_LOG_BUFFER_SIZE
+    // Log lines waiting for the UART, as records of a header and the text
+    // or the address of a flash string
+    uint8_t log_buf[FSMOS_LOG_BUFFER_SIZE];
+    uint8_t log_tail;            // Start of the oldest record
+    uint8_t log_used;
+    uint8_t log_high_water;
+    uint8_t log_line_pos;        // Characters of the oldest record already written
+    bool log_gap;                // A line was dropped since the last one queued
+    bool log_direct;             // Outside loop_once(): write lines at once
+    uint16_t log_dropped;
+    uint16_t log_truncated;
+#endif
+    uint8_t delivery_budget_msgs;
+    uint16_t delivery_budget_us;
+
+    // Delayed messages; timer_order lists occupied slots by due time
+    SharedMsg timer_msgs[FSMOS_MAX_TIMERS];
+    uint32_t timer_due[FSMOS_MAX_TIMERS];
+    uint8_t timer_generation[FSMOS_MAX_TIMERS];
+    uint8_t timer_order[FSMOS_MAX_TIMERS];
+    uint8_t timer_count;
 
 public:
   Scheduler() = default;
-  ~Scheduler() {
-    while (task_list) {
-      TaskNode* next = task_list->next;
-      delete task_list;
-      task_list = next;
-    }
-  }
   Scheduler(const Scheduler&) = delete;
   Scheduler& operator=(const Scheduler&) = delete;
 };
@@ -476,6 +1533,13 @@ extern Scheduler OS;
 
 /* ================== Task base class ================== */
 #if !defined(FSMOS_DISABLE_LEAK_DETECTION)
+/**
+ * @brief Global operator new/delete counters
+ * 
+ * On AVR, FsmOS replaces operator new and delete to keep these up to date
+ * and charges each allocation to the task that is running (see
+ * TaskMemoryInfo::heap_allocs). Byte counts are malloc chunk sizes.
+ */
 struct MemoryStats {
   uint16_t allocations;
   uint16_t deallocations;
@@ -539,17 +1603,12 @@ public:
     on_terminate();
     SharedMsg msg;
     while (suspended_msg_queue.pop(msg)) { msg.release(); }
-    // Free subscription linked list
-    while (subscription_head) {
-      SubNode* next = subscription_head->next;
-      delete subscription_head;
-      subscription_head = next;
-    }
   }
 
   /**
    * @brief Activate or resume the task
-   * Task will resume normal execution in next scheduler cycle
+   * Task will resume normal execution in next scheduler cycle; messages
+   * queued while it was suspended are delivered first, in order
    */
   void activate();
 
@@ -612,18 +1671,98 @@ public:
    */
   bool publish(uint8_t topic, uint8_t type, uint16_t arg = 0, void* ptr = nullptr, bool is_dynamic = false);
 
+  /**
+   * @brief Send a direct message after a delay
+   * 
+   * Replaces polling a stored timestamp in step(): the message arrives in
+   * on_msg() once delay_ms has passed, unless cancelled first.
+   * 
+   * @param delay_ms Milliseconds from now
+   * @param dst_task_id ID of the destination task (get_id() for a self-timeout)
+   * @param type User-defined message type
+   * @param arg Optional 16-bit argument
+   * @param ptr Optional pointer to larger data
+   * @param is_dynamic Whether ptr points to dynamically allocated data
+   * @return Handle for cancel_timer(), or TIMER_NONE on failure
+   */
+  TimerHandle tell_after(uint32_t delay_ms, uint8_t dst_task_id, uint8_t type, uint16_t arg = 0,
+                         void* ptr = nullptr, bool is_dynamic = false);
+
+  /**
+   * @brief Publish a message to a topic after a delay
+   * @param delay_ms Milliseconds from now
+   * @param topic Topic ID (1-255, 0 is reserved for direct messages)
+   * @param type User-defined message type
+   * @param arg Optional 16-bit argument
+   * @param ptr Optional pointer to larger data
+   * @param is_dynamic Whether ptr points to dynamically allocated data
+   * @return Handle for cancel_timer(), or TIMER_NONE on failure
+   */
+  TimerHandle publish_after(uint32_t delay_ms, uint8_t topic, uint8_t type, uint16_t arg = 0,
+                            void* ptr = nullptr, bool is_dynamic = false);
+
+  /**
+   * @brief Cancel a delayed message and clear its handle
+   * @param handle Handle from tell_after()/publish_after(); set to TIMER_NONE
+   * @return true if the message was still pending
+   */
+  bool cancel_timer(TimerHandle& handle) {
+    bool cancelled = OS.cancel_timer(handle);
+    handle = TIMER_NONE;
+    return cancelled;
+  }
+
+#if FSMOS_MSG_INLINE_SIZE > 0
+  /**
+   * @brief Send a direct message carrying a small inline payload
+   * 
+   * The value is copied into the message, so no heap allocation is needed.
+   * Read it in on_msg() with msg.get_payload<T>().
+   * 
+   * @param dst_task_id ID of the destination task
+   * @param type User-defined message type
+   * @param payload Value of at most FSMOS_MSG_INLINE_SIZE bytes
+   * @param arg Optional 16-bit argument
+   * @return true if message was successfully queued
+   */
+  template<typename T>
+  bool tell_payload(uint8_t dst_task_id, uint8_t type, const T& payload, uint16_t arg = 0) {
+    static_assert(sizeof(T) <= FSMOS_MSG_INLINE_SIZE, "Payload larger than FSMOS_MSG_INLINE_SIZE");
+    return OS.post(type, dst_task_id, 0, arg, nullptr, false, &payload, sizeof(T));
+  }
+
+  /**
+   * @brief Publish a message carrying a small inline payload
+   * @param topic Topic ID (1-255, 0 is reserved for direct messages)
+   * @param type User-defined message type
+   * @param payload Value of at most FSMOS_MSG_INLINE_SIZE bytes
+   * @param arg Optional 16-bit argument
+   * @return true if message was successfully queued
+   */
+  template<typename T>
+  bool publish_payload(uint8_t topic, uint8_t type, const T& payload, uint16_t arg = 0) {
+    static_assert(sizeof(T) <= FSMOS_MSG_INLINE_SIZE, "Payload larger than FSMOS_MSG_INLINE_SIZE");
+    if (topic == 0) return false;
+    return OS.post(type, id, topic, arg, nullptr, false, &payload, sizeof(T));
+  }
+#endif
+
   /** 
    * @brief Subscribe to messages on a specific topic
-   * @param topic Topic ID to subscribe to (1-255)
+   * @param topic Topic ID to subscribe to (1 to FSMOS_MAX_TOPICS-1)
+   * @return true if the topic is valid and now subscribed
    */
-  void subscribe(uint8_t topic);
+  bool subscribe(uint8_t topic);
 
   /**
    * @brief Check if task is subscribed to a topic
    * @param topic Topic ID to check
    * @return true if task is subscribed to the topic
    */
-  bool is_subscribed_to(uint8_t topic);
+  inline bool is_subscribed_to(uint8_t topic) const {
+    if (topic == 0 || (uint16_t)topic >= FSMOS_MAX_TOPICS) return false;
+    return subscriptions[topic >> 3] & (1 << (topic & 7));
+  }
 
   /**
    * @brief Get the task's unique identifier
@@ -633,18 +1772,60 @@ public:
 
   /**
    * @brief Set the task's execution period
-   * @param period Time in milliseconds between step() calls
+   * 
+   * Takes effect after the already scheduled run; next_due is unchanged.
+   * A period of 0 makes the task event-driven: it is never scheduled
+   * periodically and step() only runs after on_msg() delivered a message.
+   * 
+   * @param period Time in milliseconds between step() calls (0 = on message only)
    */
   void set_period(uint16_t period);
 
+  /**
+   * @brief Run step() right after a message is delivered
+   * 
+   * Periodic tasks keep their period but also step in the same scheduler
+   * iteration as the on_msg() call, instead of waiting for next_due.
+   * Tasks with period 0 always behave this way.
+   * 
+   * @param wake true to step immediately after message delivery
+   */
+  void set_wake_on_msg(bool wake) { wake_on_msg = wake; }
+
+  /**
+   * @brief Check whether message delivery wakes the task
+   * @return true if step() runs right after on_msg()
+   */
+  bool get_wake_on_msg() const { return wake_on_msg || period_ms == 0; }
+
   /**
    * @brief Get the task's current execution period
    * @return Time in milliseconds between step() calls
    */
   uint16_t get_period() const;
 
+  /**
+   * @brief Set the task's priority
+   * 
+   * Used by SCHED_FIXED_PRIORITY to order tasks that are due in the same
+   * scheduler iteration. Higher values run first; the default is 0.
+   * 
+   * @param p Priority (0-255)
+   */
+  void set_priority(uint8_t p) { priority = p; }
+
+  /**
+   * @brief Get the task's priority
+   * @return Priority set with set_priority()
+   */
+  uint8_t get_priority() const { return priority; }
+
   /**
    * @brief Configure message queueing during suspension
+   * 
+   * Queued messages wait in the task's mailbox (FSMOS_TASK_QUEUE_SIZE
+   * entries); see Scheduler::get_mailbox_stats().
+   * 
    * @param queue_messages true to queue messages, false to discard
    */
   void set_queue_messages_while_suspended(bool queue_messages);
@@ -667,36 +1848,71 @@ public:
    */
   const __FlashStringHelper* get_name() const { return task_name ? task_name : F("Unknown"); }
 
+  /**
+   * @brief Set the lowest level this task logs
+   * 
+   * Levels below FSMOS_LOG_LEVEL stay compiled out whatever is set here.
+   * 
+   * @param level LOG_DEBUG..LOG_ERROR, or LOG_NONE to silence the task
+   */
+  void set_log_level(LogLevel level) { log_levels = level > LOG_ERROR ? 0 : (0x0F << level) & 0x0F; }
+
+  /**
+   * @brief Get the lowest level this task logs
+   * @return LOG_DEBUG..LOG_ERROR, or LOG_NONE if the task is silenced
+   */
+  LogLevel get_log_level() const;
+
+  /**
+   * @brief Check whether a log call at this level would produce output
+   * 
+   * Checked before any formatting. With a constant level below
+   * FSMOS_LOG_LEVEL this is a compile-time false.
+   */
+  bool log_enabled(LogLevel level) const {
+    return level >= FSMOS_LOG_LEVEL && level <= LOG_ERROR && ((log_levels >> level) & 1);
+  }
+
   /**
    * @brief Log a message with specified severity level
    * @param level Message severity level
    * @param msg Message text (stored in flash)
    */
-  inline void log(LogLevel level, const __FlashStringHelper* msg) { OS.logMessage(this, level, msg); }
+  inline void log(LogLevel level, const __FlashStringHelper* msg) {
+    if (log_enabled(level)) OS.logMessage(this, level, msg);
+  }
 
   /**
    * @brief Log a debug message
    * @param msg Debug message text (stored in flash)
    */
-  inline void log_debug(const __FlashStringHelper* msg) { OS.logMessage(this, LOG_DEBUG, msg); }
+  inline void log_debug(const __FlashStringHelper* msg) {
+    if (log_enabled(LOG_DEBUG)) OS.logMessage(this, LOG_DEBUG, msg);
+  }
 
   /**
    * @brief Log an informational message
    * @param msg Info message text (stored in flash)
    */
-  inline void log_info(const __FlashStringHelper* msg) { OS.logMessage(this, LOG_INFO, msg); }
+  inline void log_info(const __FlashStringHelper* msg) {
+    if (log_enabled(LOG_INFO)) OS.logMessage(this, LOG_INFO, msg);
+  }
 
   /**
    * @brief Log a warning message
    * @param msg Warning message text (stored in flash)
    */
-  inline void log_warn(const __FlashStringHelper* msg) { OS.logMessage(this, LOG_WARNING, msg); }
+  inline void log_warn(const __FlashStringHelper* msg) {
+    if (log_enabled(LOG_WARNING)) OS.logMessage(this, LOG_WARNING, msg);
+  }
 
   /**
    * @brief Log an error message
    * @param msg Error message text (stored in flash)
    */
-  inline void log_error(const __FlashStringHelper* msg) { OS.logMessage(this, LOG_ERROR, msg); }
+  inline void log_error(const __FlashStringHelper* msg) {
+    if (log_enabled(LOG_ERROR)) OS.logMessage(this, LOG_ERROR, msg);
+  }
 
   /**
    * @brief Process pending messages for this task
@@ -709,16 +1925,21 @@ private:
 
   uint32_t next_due = 0;
   uint16_t period_ms = 1;
-  uint8_t id = 255;
+  uint8_t id = FSMOS_NO_TASK;
   uint8_t subscription_count = 0;
+  uint8_t priority = 0;
   const __FlashStringHelper* task_name = nullptr;
   TaskState state;
   uint8_t queue_messages_while_suspended:1;
+  uint8_t wake_on_msg:1;
+  uint8_t log_levels:4;  // Bit n set: LogLevel n is logged
   
-  // Subscription linked list (unlimited topics)
-  struct SubNode { uint8_t topic; SubNode* next; SubNode(uint8_t t) : topic(t), next(nullptr) {} };
-  SubNode* subscription_head = nullptr;
-  LinkedQueue<SharedMsg> suspended_msg_queue;
+  // Subscription bitmap, one bit per topic ID
+  uint8_t subscriptions[(FSMOS_MAX_TOPICS + 7) / 8];
+  TaskQueue suspended_msg_queue;
+
+  // Scheduler list/slot/run-queue linkage, kept here instead of on the heap
+  TaskNode node;
 
 public:
   explicit Task(const __FlashStringHelper* name = nullptr) {
@@ -726,7 +1947,9 @@ public:
     subscription_count = 0;
     state = ACTIVE;
     queue_messages_while_suspended = 1;
-    subscription_head = nullptr;
+    wake_on_msg = 0;
+    set_log_level(FSMOS_TASK_LOG_LEVEL);
+    memset(subscriptions, 0, sizeof(subscriptions));
   }
 };
 
@@ -758,3 +1981,67 @@ struct __attribute__((packed)) Timer {
     return duration_ms == 0 || (int32_t)(OS.now() - start_ms) >= (int32_t)duration_ms; 
   }
 };
+
+#if FSMOS_PIN_CHANGE_INPUT
+/* ================== Pin-change Input ================== */
+/**
+ * @brief Edge capture on the ATmega328P pin-change interrupts
+ * 
+ * Each port has one PCINT vector: port B (D8-D13), port C (A0-A5) and
+ * port D (D0-D7). On an edge of a watched pin the vector posts a message
+ * on the topic given for that port, via post_from_isr(), with
+ * - arg high byte: pins that changed, low byte: levels of the watched
+ *   pins, both as port bit masks (compare with mask())
+ * - payload: micros() of the edge (FSMOS_MSG_INLINE_SIZE >= 4)
+ * - src_id: FSMOS_NO_TASK
+ * 
+ * Tasks subscribe to the topic and run only when an edge arrives; a
+ * task that needs debouncing re-reads the pin after a tell_after().
+ * The three vectors never nest, so they share one ring.
+ */
+class PinChangeInput {
+public:
+  static const uint8_t PORT_COUNT = 3;
+
+  /**
+   * @brief Watch a pin and enable its pin-change interrupt
+   * @param pin Arduino pin number (0-13, A0-A5)
+   * @param topic Topic for edges on the pin's port
+   * @param type Message type for edges on the pin's port
+   * @return false if the pin has no PCINT or its port already uses another topic/type
+   */
+  static bool watch(uint8_t pin, uint8_t topic, uint8_t type);
+
+  /** @brief Bit of a pin within its port, for testing arg (0 if the pin has no PCINT) */
+  static uint8_t mask(uint8_t pin);
+
+  /** @brief Whether pin changed in the edge message msg */
+  static bool changed(const MsgData& msg, uint8_t pin) { return (msg.arg >> 8) & mask(pin); }
+
+  /**
+   * @brief Simulate an edge, for host builds without PCINT hardware
+   * 
+   * Updates the pin's level in the port image and runs the same capture
+   * path as the interrupt vector.
+   * 
+   * @param pin Arduino pin number
+   * @param level New level (HIGH/LOW)
+   */
+  static void inject(uint8_t pin, uint8_t level);
+
+  /** @brief Edges lost because the ring was full */
+  static uint8_t dropped() { return queue.dropped(); }
+
+  /** @brief Called by the PCINT vectors with the port's input register */
+  static void capture(uint8_t port, uint8_t levels);
+
+private:
+  static uint8_t port_of(uint8_t pin);
+
+  static IsrQueue<FSMOS_PIN_CHANGE_QUEUE_SIZE> queue;
+  static uint8_t watched[PORT_COUNT];  // Watched pins per port
+  static uint8_t levels[PORT_COUNT];   // Levels seen by the last capture
+  static uint8_t topics[PORT_COUNT];
+  static uint8_t types[PORT_COUNT];
+};
+#endif
@@ -88,21 +88,21 @@ private:
   void print_task_stats() {
     Serial.println(F("Task Statistics:"));
     
-    for (uint8_t i = 0; i < OS.get_task_count(); i++) {
-      Task* t = OS.get_task(i);
-      if (!t) continue;  // Skip if task doesn't exist
-      
+    // Task IDs are not 0..count-1 once slots are reused; walk the slots
+    uint8_t cursor = 0;
+    while (Task* t = OS.next_task(cursor)) {
+      uint8_t id = t->get_id();
       TaskStats stats;
       TaskMemoryInfo mem_info;
       
       Serial.print(F("  Task "));
       Serial.print(t->get_name());  // Use task name instead of just ID
       Serial.print(F(" (#"));
-      Serial.print(i);
+      Serial.print(id);
       Serial.println(F("):"));
       
       // Get and print CPU stats
-      if (OS.get_task_stats(i, stats)) {
+      if (OS.get_task_stats(id, stats)) {
         Serial.print(F("    CPU: Max="));
         Serial.print(stats.max_exec_time_us);
         Serial.print(F("µs, Avg="));
@@ -112,7 +112,7 @@ private:
       }
       
       // Get and print memory stats
-      if (OS.get_task_memory_info(i, mem_info)) {
+      if (OS.get_task_memory_info(id, mem_info)) {
         Serial.print(F("    Mem: Task="));
         Serial.print(mem_info.task_struct_size);
         Serial.print(F("B, Queue="));
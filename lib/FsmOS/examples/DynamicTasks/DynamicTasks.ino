@@ -217,19 +217,23 @@ public:
     if (cleanup_timer.expired()) {
       uint8_t cleaned_this_cycle = 0;
       
-      // Scan all task slots for terminated tasks
-      for (uint8_t i = 0; i < FSMOS_MAX_TASKS; ++i) {
-        Task* t = os.get_task(i);
+      // Scan all task slots for terminated tasks. Task IDs carry a
+      // generation, so a reused slot has a new ID: walk the slots instead
+      // of counting IDs up from 0.
+      uint8_t cursor = 0;
+      while (Task* t = os.next_task(cursor)) {
+        uint8_t id = t->get_id();
         
         // Check for terminated tasks that can be cleaned up
-        if (t && !t->is_active()) {
+        if (!t->is_active()) {
           // Protect static tasks from deletion
           if (t != (Task*)producer_task_ptr && t != (Task*)cleanup_task_ptr) {
-            log_info(F("Cleanup: Removing terminated task #%d"), t->get_id());
+            log_info(F("Cleanup: Removing terminated task #%d"), id);
             
-            // Free the task's memory and clean up OS resources
-            delete os.get_task(i);  // Free heap memory
-            os.remove(i);           // Clear task slot
+            // Unregister first: remove() still reads the node embedded
+            // in the task, so the task must not be deleted before it
+            os.remove(id);  // Clear task slot
+            delete t;       // Free heap memory
             
             cleaned_this_cycle++;
             total_cleaned++;
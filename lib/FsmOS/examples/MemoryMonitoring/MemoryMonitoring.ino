@@ -130,20 +130,18 @@ protected:
     Serial.println(F("============"));
     
     // Print info for each task
-    for (uint8_t i = 0; i < OS.get_task_count(); i++) {
-      Task* task = OS.get_task(i);
-      if (task) {
-        TaskMemoryInfo task_info;
-        OS.get_task_memory_info(i, task_info);
-        
-        Serial.print(F("\nTask '"));
-        Serial.print(task->get_name());
-        Serial.println(F("':"));
-        print_size(F("  Structure:    "), task_info.task_struct_size);
-        print_size(F("  Subscriptions: "), task_info.subscription_size);
-        print_size(F("  Queue:        "), task_info.queue_size);
-        print_size(F("  Total:        "), task_info.total_allocated);
-      }
+    uint8_t cursor = 0;
+    while (Task* task = OS.next_task(cursor)) {
+      TaskMemoryInfo task_info;
+      OS.get_task_memory_info(task->get_id(), task_info);
+      
+      Serial.print(F("\nTask '"));
+      Serial.print(task->get_name());
+      Serial.println(F("':"));
+      print_size(F("  Structure:    "), task_info.task_struct_size);
+      print_size(F("  Subscriptions: "), task_info.subscription_size);
+      print_size(F("  Queue:        "), task_info.queue_size);
+      print_size(F("  Total:        "), task_info.total_allocated);
     }
     
     Serial.println(F("\n"));
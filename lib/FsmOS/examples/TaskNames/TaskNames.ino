@@ -55,39 +55,37 @@ protected:
     Serial.println(F("---------------"));
     
     // Iterate through all tasks
-    for (uint8_t i = 0; i < OS.get_task_count(); i++) {
-      Task* task = OS.get_task(i);
-      if (task) {
-        TaskStats stats;
-        OS.get_task_stats(i, stats);
-        
-        // Print task info using stored name
-        Serial.print(F("Task '"));
-        Serial.print(task->get_name());  // Uses task name from PROGMEM
-        Serial.print(F("' (ID:"));
-        Serial.print(task->get_id());
-        Serial.print(F("): "));
-        
-        // Print state
-        switch(task->get_state()) {
-          case Task::ACTIVE:
-            Serial.print(F("ACTIVE"));
-            break;
-          case Task::SUSPENDED:
-            Serial.print(F("SUSPENDED"));
-            break;
-          case Task::INACTIVE:
-            Serial.print(F("INACTIVE"));
-            break;
-        }
-        
-        // Print stats
-        Serial.print(F(", Runs: "));
-        Serial.print(stats.run_count);
-        Serial.print(F(", Max Time: "));
-        Serial.print(stats.max_exec_time_us);
-        Serial.println(F("us"));
+    uint8_t cursor = 0;
+    while (Task* task = OS.next_task(cursor)) {
+      TaskStats stats;
+      OS.get_task_stats(task->get_id(), stats);
+      
+      // Print task info using stored name
+      Serial.print(F("Task '"));
+      Serial.print(task->get_name());  // Uses task name from PROGMEM
+      Serial.print(F("' (ID:"));
+      Serial.print(task->get_id());
+      Serial.print(F("): "));
+      
+      // Print state
+      switch(task->get_state()) {
+        case Task::ACTIVE:
+          Serial.print(F("ACTIVE"));
+          break;
+        case Task::SUSPENDED:
+          Serial.print(F("SUSPENDED"));
+          break;
+        case Task::INACTIVE:
+          Serial.print(F("INACTIVE"));
+          break;
       }
+      
+      // Print stats
+      Serial.print(F(", Runs: "));
+      Serial.print(stats.run_count);
+      Serial.print(F(", Max Time: "));
+      Serial.print(stats.max_exec_time_us);
+      Serial.println(F("us"));
     }
   }
 };
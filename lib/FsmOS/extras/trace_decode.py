@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Turn an FsmOS flight recorder dump into a readable timeline.
+
+Capture the output of the serial "trace" command (lines of the form
+TR,event,time_ms,id,arg) into a file and run:
+
+    trace_decode.py capture.txt [--elf firmware.elf]
+
+If the capture also contains the output of the "stats" command, task IDs
+are shown with their names. With --elf, log events are resolved to their
+message text (needs avr-objcopy on the PATH).
+
+Times are relative to the last recorded event, which after a watchdog
+reset is the last thing the firmware did.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+TRACE_TASK_START = 1
+TRACE_TASK_END = 2
+TRACE_MSG_POST = 3
+TRACE_MSG_DELIVER = 4
+TRACE_LOG = 5
+TRACE_MSG_TELL = 6
+
+RECORD_RE = re.compile(r"TR,(\d+),(\d+),(\d+),(\d+)")
+TASK_RE = re.compile(r"Task (\d+) \(([^)]*)\)")
+
+# Timestamps are millis() modulo 8192
+TIME_MASK = 0x1FFF
+
+
+def load_flash(elf_path):
+    """Return the program memory image of a firmware ELF, or None."""
+    fd, bin_path = tempfile.mkstemp(suffix=".bin")
+    os.close(fd)
+    try:
+        subprocess.run(["avr-objcopy", "-O", "binary", "-j", ".text", elf_path, bin_path], check=True)
+        with open(bin_path, "rb") as f:
+            return f.read()
+    except (OSError, subprocess.CalledProcessError) as e:
+        print("warning: cannot read %s: %s" % (elf_path, e), file=sys.stderr)
+        return None
+    finally:
+        os.unlink(bin_path)
+
+
+def flash_string(flash, addr):
+    if flash is None or addr >= len(flash):
+        return None
+    end = flash.find(b"\0", addr)
+    if end < 0:
+        end = len(flash)
+    return flash[addr:end].decode("ascii", "replace")
+
+
+def parse(lines):
+    records = []
+    names = {}
+    for line in lines:
+        m = RECORD_RE.search(line)
+        if m:
+            records.append(tuple(int(v) for v in m.groups()))
+            continue
+        m = TASK_RE.search(line)
+        if m:
+            names[int(m.group(1))] = m.group(2)
+    return records, names
+
+
+def task_label(names, task_id):
+    name = names.get(task_id)
+    return "task %d (%s)" % (task_id, name) if name else "task %d" % task_id
+
+
+def describe(event, task_id, arg, names, flash):
+    if event == TRACE_TASK_START:
+        return "%s step() start" % task_label(names, task_id)
+    if event == TRACE_TASK_END:
+        return "%s step() end" % task_label(names, task_id)
+    if event == TRACE_MSG_POST:
+        return "post type %d on topic %d" % (task_id, arg)
+    if event == TRACE_MSG_TELL:
+        return "tell type %d to %s" % (task_id, task_label(names, arg))
+    if event == TRACE_MSG_DELIVER:
+        return "%s on_msg() type %d" % (task_label(names, arg), task_id)
+    if event == TRACE_LOG:
+        addr = task_id | (arg << 8)
+        text = flash_string(flash, addr)
+        return "log \"%s\"" % text if text is not None else "log @0x%04x" % addr
+    return "unknown event %d (%d, %d)" % (event, task_id, arg)
+
+
+def decode(records, names, flash):
+    if not records:
+        return ["no trace records found"]
+
+    # Unwrap the 13-bit timestamps into milliseconds since the first event
+    times = [0]
+    for prev, cur in zip(records, records[1:]):
+        times.append(times[-1] + ((cur[1] - prev[1]) & TIME_MASK))
+    last = times[-1]
+
+    out = []
+    running = []
+    for (event, _, task_id, arg), t in zip(records, times):
+        if event == TRACE_TASK_END and task_id in running:
+            running.remove(task_id)
+        indent = "  " * len(running)
+        out.append("%+8d ms  %s%s" % (t - last, indent, describe(event, task_id, arg, names, flash)))
+        if event == TRACE_TASK_START:
+            running.append(task_id)
+
+    for task_id in running:
+        out.append("          %s had not returned when the trace ended" % task_label(names, task_id))
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="serial capture (default: stdin)")
+    parser.add_argument("--elf", help="firmware ELF, to show log message text")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, encoding="ascii", errors="replace") as f:
+            lines = f.readlines()
+    else:
+        lines = sys.stdin.readlines()
+
+    records, names = parse(lines)
+    flash = load_flash(args.elf) if args.elf else None
+    for line in decode(records, names, flash):
+        print(line)
+
+
+if __name__ == "__main__":
+    main()
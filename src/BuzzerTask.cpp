@@ -1,11 +1,12 @@
 #include "BuzzerTask.h"
 
 BuzzerTask::BuzzerTask() {
-    set_period(50); // Check every 50ms for responsive sound control
+    set_period(0); // Event-driven: sound end and angry repeat arrive as delayed messages
     currentState = BUZZER_IDLE;
     soundStartTime = 0;
     soundDuration = 0;
     currentFrequency = 0;
+    soundTimer = TIMER_NONE;
     isPlaying = false;
 }
 
@@ -76,31 +77,37 @@ void BuzzerTask::on_msg(const MsgData& msg) {
             playChildLockSelected();
             break;
             
+        // Delayed messages scheduled by this task. A timer that fired just before a
+        // new sound started can still be queued, so both check the elapsed time.
+        case EVT_BUZZER_SOUND_DONE:
+            if (isPlaying && currentState == BUZZER_PLAYING &&
+                OS.now() - soundStartTime >= soundDuration) {
+                stopSound();
+            }
+            break;
+            
+        case EVT_BUZZER_ANGRY_REPEAT:
+            if (currentState == BUZZER_ANGRY_CONTINUOUS &&
+                OS.now() - soundStartTime >= soundDuration) {
+                // Restart the angry sound
+                tone(BUZZER_PIN, currentFrequency, soundDuration);
+                soundStartTime = OS.now();
+                restartSoundTimer(EVT_BUZZER_ANGRY_REPEAT);
+            }
+            break;
+            
         default:
             break;
     }
 }
 
 void BuzzerTask::step() {
-    unsigned long currentTime = OS.now();
-    
-    // Check if current sound should stop
-    if (isPlaying && currentState == BUZZER_PLAYING) {
-        if (currentTime - soundStartTime >= soundDuration) {
-            stopSound();
-        }
-    }
-    
-    // Handle continuous angry sound
-    if (currentState == BUZZER_ANGRY_CONTINUOUS) {
-        if (currentTime - soundStartTime >= soundDuration) {
-            // Restart the angry sound
-            tone(BUZZER_PIN, currentFrequency, soundDuration);
-            soundStartTime = currentTime;
-        }
-    }
-    
-    // Process any received messages
+    // Nothing to poll: sound timing is driven by delayed messages
+}
+
+void BuzzerTask::restartSoundTimer(uint8_t eventType) {
+    cancel_timer(soundTimer);
+    soundTimer = tell_after(soundDuration, get_id(), eventType);
 }
 
 void BuzzerTask::playButtonPress() {
@@ -148,6 +155,7 @@ void BuzzerTask::startAngrySound() {
     isPlaying = true;
     
     tone(BUZZER_PIN, currentFrequency, soundDuration);
+    restartSoundTimer(EVT_BUZZER_ANGRY_REPEAT);
     log_info(F("Continuous angry sound started - unauthorized access"));
 }
 
@@ -155,6 +163,7 @@ void BuzzerTask::stopAngrySound() {
     // Stop continuous angry sound
     currentState = BUZZER_IDLE;
     isPlaying = false;
+    cancel_timer(soundTimer);
     noTone(BUZZER_PIN);
     log_info(F("Continuous angry sound stopped"));
 }
@@ -168,11 +177,13 @@ void BuzzerTask::startSound(uint16_t frequency, unsigned long duration) {
     
     // Generate tone using Arduino tone() function
     tone(BUZZER_PIN, frequency, duration);
+    restartSoundTimer(EVT_BUZZER_SOUND_DONE);
 }
 
 void BuzzerTask::stopSound() {
     currentState = BUZZER_IDLE;
     isPlaying = false;
+    cancel_timer(soundTimer);
     noTone(BUZZER_PIN); // Stop any playing tone
 }
 
@@ -23,6 +23,7 @@ private:
     unsigned long soundStartTime;
     unsigned long soundDuration;
     uint16_t currentFrequency;
+    TimerHandle soundTimer; // pending EVT_BUZZER_SOUND_DONE or EVT_BUZZER_ANGRY_REPEAT
     uint8_t isPlaying:1;
     
     // Sound patterns
@@ -40,6 +41,7 @@ private:
     void playBothDoorsSelected();
     void playChildLockSelected();
     
+    void restartSoundTimer(uint8_t eventType);
     void startSound(uint16_t frequency, unsigned long duration);
     void stopSound();
 };
@@ -1,10 +1,11 @@
 #include "ChildLockTask.h"
 
 ChildLockTask::ChildLockTask() : Task(nullptr) {
-    set_period(100); // Check every 100ms
+    set_period(0); // Event-driven: the timeout arrives as a delayed message
     childLockEngaged = true; // Start with child lock engaged (locked)
     deviceRunning = true; // Assume device is running initially
     childLockReleaseTime = 0;
+    timeoutTimer = TIMER_NONE;
 }
 
 void ChildLockTask::on_start() {
@@ -34,7 +35,7 @@ void ChildLockTask::on_msg(const MsgData& msg) {
             break;
         case EVT_CHILD_LOCK_TIMEOUT_RESET:
             if (!childLockEngaged) {
-                childLockReleaseTime = OS.now();
+                restartTimeout();
                 log_info(F("Child lock timeout reset (1 minute)"));
             }
             break;
@@ -54,7 +55,15 @@ void ChildLockTask::on_msg(const MsgData& msg) {
         case EVT_KEYPAD_4_PRESSED:
             if (!childLockEngaged) {
                 log_info(F("Keypad 4 pressed - resetting child lock timeout"));
-                childLockReleaseTime = OS.now();
+                restartTimeout();
+            }
+            break;
+        case EVT_CHILD_LOCK_TIMEOUT:
+            // A timeout that fired just before a reset can still be queued, so check elapsed time
+            if (!childLockEngaged && childLockReleaseTime != 0 &&
+                OS.now() - childLockReleaseTime >= CHILD_LOCK_TIMEOUT_MS) {
+                log_info(F("Child lock timeout reached - engaging child lock"));
+                engageChildLock();
             }
             break;
             
@@ -64,15 +73,13 @@ void ChildLockTask::on_msg(const MsgData& msg) {
 }
 
 void ChildLockTask::step() {
-    // Process any received messages
-    
-    // Auto re-engage child lock after timeout if released
-    if (!childLockEngaged && childLockReleaseTime != 0) {
-        if (OS.now() - childLockReleaseTime >= CHILD_LOCK_TIMEOUT_MS) {
-            log_info(F("Child lock timeout reached - engaging child lock"));
-            engageChildLock();
-        }
-    }
+    // Nothing to poll: auto re-engage is driven by EVT_CHILD_LOCK_TIMEOUT
+}
+
+void ChildLockTask::restartTimeout() {
+    childLockReleaseTime = OS.now();
+    cancel_timer(timeoutTimer);
+    timeoutTimer = tell_after(CHILD_LOCK_TIMEOUT_MS, get_id(), EVT_CHILD_LOCK_TIMEOUT);
 }
 
 void ChildLockTask::releaseChildLock() {
@@ -87,13 +94,14 @@ void ChildLockTask::releaseChildLock() {
     // Update status LED to indicate child lock disabled
     publish(TOPIC_STATUS_LED_EVENTS, EVT_LED_CHILD_UNLOCKED, 0, nullptr);
     // Start timeout countdown
-    childLockReleaseTime = OS.now();
+    restartTimeout();
 }
 
 void ChildLockTask::engageChildLock() {
     childLockEngaged = true;
     updateChildLockState();
     childLockReleaseTime = 0; // clear timeout tracking
+    cancel_timer(timeoutTimer);
     // Set LED back to locked state
     publish(TOPIC_STATUS_LED_EVENTS, EVT_LED_LOCKED, 0, nullptr);
 }
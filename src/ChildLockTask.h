@@ -16,7 +16,9 @@ private:
     uint8_t childLockEngaged:1; // true = locked (screen/power disabled), false = unlocked
     uint8_t deviceRunning:1; // true = device is running, false = device is stopped
     unsigned long childLockReleaseTime; // timestamp when released for timeout tracking
+    TimerHandle timeoutTimer; // pending EVT_CHILD_LOCK_TIMEOUT
     
+    void restartTimeout();
     void releaseChildLock();
     void engageChildLock();
     void updateChildLockState();
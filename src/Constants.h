@@ -40,6 +40,7 @@
 // Event message types
 #define EVT_BUTTON_SHORT_CLICK 1
 #define EVT_BUTTON_LONG_CLICK  2
+#define EVT_BUTTON_LONG_PRESS_CHECK 3  // Delayed message to YellowButtonTask
 
 // Message topics
 #define TOPIC_BUTTON_EVENTS 1
@@ -53,6 +54,10 @@
 #define TOPIC_CHILD_LOCK_EVENTS 9
 #define TOPIC_MB_LIGHT_SENSOR_EVENTS 10
 #define TOPIC_DEVICE_RUNNING_EVENTS 11
+// Pin-change edges, one topic per port (PinChangeInput)
+#define TOPIC_PIN_CHANGE_PORT_B 12  // D8-D13: door sensors
+#define TOPIC_PIN_CHANGE_PORT_C 13  // A0-A5: device running sensor
+#define TOPIC_PIN_CHANGE_PORT_D 14  // D0-D7: keypad, yellow button, MB light sensor
 
 // Keypad event types
 #define EVT_KEYPAD_1_PRESSED 10
@@ -64,6 +69,7 @@
 #define EVT_KEYPAD_2_LONG_PRESSED 15
 #define EVT_KEYPAD_3_LONG_PRESSED 16
 #define EVT_KEYPAD_4_LONG_PRESSED 17
+#define EVT_KEYPAD_LONG_PRESS_CHECK 18  // Delayed message to KeypadTask, arg = key index
 
 // Status LED event types
 #define EVT_LED_LOCKED 20
@@ -93,6 +99,12 @@
 #define EVT_DOOR_TOP_OPENED 61
 #define EVT_DOOR_FRONT_CLOSED 62
 #define EVT_DOOR_TOP_CLOSED 63
+// Door control self-timeouts (delayed messages to DoorControlTask)
+#define EVT_DOOR_FRONT_MAGNET_DELAY 64
+#define EVT_DOOR_TOP_MAGNET_DELAY 65
+#define EVT_DOOR_FRONT_REENGAGE 66
+#define EVT_DOOR_TOP_REENGAGE 67
+#define EVT_DOOR_SENSOR_SETTLE 68  // Delayed message to DoorSensorTask after an edge
 
 // Buzzer event types
 #define EVT_BUZZER_BUTTON_PRESS 70
@@ -113,6 +125,14 @@
 #define EVT_CHILD_LOCK_RELEASE 83
 #define EVT_CHILD_LOCK_ENGAGE 84
 #define EVT_CHILD_LOCK_TIMEOUT_RESET 85
+#define EVT_CHILD_LOCK_TIMEOUT 86  // Delayed message to ChildLockTask
+
+// Buzzer self-timeouts (delayed messages to BuzzerTask)
+#define EVT_BUZZER_SOUND_DONE 87
+#define EVT_BUZZER_ANGRY_REPEAT 88
+
+// Input pin edge (PinChangeInput), arg = changed pins << 8 | levels
+#define EVT_PIN_CHANGE 90
 
 // Button timing constants
 #define DEBOUNCE_TIME_MS 50
@@ -126,6 +146,21 @@
 // Child lock timing
 #define CHILD_LOCK_TIMEOUT_MS 60000  // 1 minute auto re-engage
 
+// Delayed messages the app can have pending at once; FSMOS_MAX_TIMERS
+// must cover them or tell_after() returns TIMER_NONE:
+//   KeypadTask long press      4 (one per key, all held)
+//   YellowButtonTask long press 1
+//   DoorControlTask magnet      2 (front, top)
+//   DoorControlTask re-engage   2 (front, top)
+//   DoorSensorTask settle       1
+//   ChildLockTask timeout       1
+//   PasswordManagerTask timeout 1
+//   BuzzerTask sound            1
+#define APP_MAX_PENDING_TIMERS 13
+// Pending timers hold message pool slots, so platformio.ini sizes
+// FSMOS_MSG_POOL_SIZE for these 13, a full 8-entry bus and the message
+// being delivered: 22
+
 // EEPROM layout (avoid address 0 used by light brightness)
 #define EEPROM_PASSWORD_MAGIC_ADDR 16
 #define EEPROM_PASSWORD_ADDR       17  // 17..20 inclusive for 4-digit PIN
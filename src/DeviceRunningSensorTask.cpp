@@ -3,6 +3,10 @@
 void DeviceRunningSensorTask::on_start() {
     pinMode(DEVICE_RUNNING_SENSOR_PIN, INPUT_PULLUP);
     
+    // Get an EVT_PIN_CHANGE message on every sensor edge
+    PinChangeInput::watch(DEVICE_RUNNING_SENSOR_PIN, TOPIC_PIN_CHANGE_PORT_C, EVT_PIN_CHANGE);
+    subscribe(TOPIC_PIN_CHANGE_PORT_C);
+    
     log_info(F("Task started - Pin=A4"));
     log_info(F("Monitors device running state"));
     
@@ -13,14 +17,13 @@ void DeviceRunningSensorTask::on_start() {
 }
 
 void DeviceRunningSensorTask::step() {
-    readDeviceRunningSensor();
-    
-    // Process any received messages
+    // Nothing to poll: sensor edges arrive as EVT_PIN_CHANGE messages
 }
 
 void DeviceRunningSensorTask::on_msg(const MsgData& msg) {
-    // This task doesn't handle incoming messages
-    (void)msg;
+    if (msg.type == EVT_PIN_CHANGE) {
+        readDeviceRunningSensor();
+    }
 }
 
 void DeviceRunningSensorTask::readDeviceRunningSensor() {
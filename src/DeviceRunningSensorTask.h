@@ -6,7 +6,7 @@
 class DeviceRunningSensorTask : public Task {
 public:
     DeviceRunningSensorTask() {
-        set_period(200); // Check every 200ms
+        set_period(0); // Event-driven: woken by pin-change edges on the sensor
     }
 
 protected:
@@ -1,7 +1,7 @@
 #include "DiagnosticTask.h"
 
 DiagnosticTask::DiagnosticTask() {
-    set_period(1000); // Check every 1 second (no automatic printing)
+    set_period(0); // Event-driven: no periodic work (no automatic printing)
 }
 
 void DiagnosticTask::on_start() {
@@ -19,7 +19,9 @@ void DiagnosticTask::displayResetInfo() {
         Serial.print(F("RESET_INFO: Reset Reason="));
         Serial.print(resetInfo.reset_reason);
         Serial.print(F(", Last Task="));
-        Serial.println(resetInfo.last_task_id);
+        Serial.print(resetInfo.last_task_id);
+        Serial.print(F(", Trace Events="));
+        Serial.println(resetInfo.trace_count);
     }
 }
 
@@ -28,29 +30,31 @@ void DiagnosticTask::displayTaskStats() {
     Serial.print(F("TASK_STATS: Total tasks="));
     Serial.println(taskCount);
     
-    for (uint8_t i = 0; i < taskCount; i++) {
+    uint8_t cursor = 0;
+    while (Task* task = OS.next_task(cursor)) {
         TaskStats stats;
-        if (OS.get_task_stats(i, stats)) {
-            Task* task = OS.get_task(i);
-            if (task) {
-                Serial.print(F("  Task "));
-                Serial.print(i);
-                Serial.print(F(" ("));
-                Serial.print(task->get_name());
-                Serial.print(F("): Runs="));
-                Serial.print(stats.run_count);
-                Serial.print(F(", MaxTime="));
-                Serial.print(stats.max_exec_time_us);
-                Serial.print(F("us, AvgTime="));
-                if (stats.run_count > 0) {
-                    Serial.print(stats.total_exec_time_us / stats.run_count);
-                } else {
-                    Serial.print(0);
-                }
-                Serial.print(F("us, Period="));
-                Serial.print(task->get_period());
-                Serial.println(F("ms"));
+        if (OS.get_task_stats(task->get_id(), stats)) {
+            Serial.print(F("  Task "));
+            Serial.print(task->get_id());
+            Serial.print(F(" ("));
+            Serial.print(task->get_name());
+            Serial.print(F("): Runs="));
+            Serial.print(stats.run_count);
+            Serial.print(F(", MaxTime="));
+            Serial.print(stats.max_exec_time_us);
+            Serial.print(F("us, AvgTime="));
+            if (stats.run_count > 0) {
+                Serial.print(stats.total_exec_time_us / stats.run_count);
+            } else {
+                Serial.print(0);
             }
+            Serial.print(F("us, MaxLate="));
+            Serial.print(stats.max_lateness_ms);
+            Serial.print(F("ms, Missed="));
+            Serial.print(stats.missed_deadlines);
+            Serial.print(F(", Period="));
+            Serial.print(task->get_period());
+            Serial.println(F("ms"));
         }
     }
 }
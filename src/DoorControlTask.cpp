@@ -1,19 +1,17 @@
 #include "DoorControlTask.h"
 
 DoorControlTask::DoorControlTask() {
-    set_period(100); // Check every 100ms
+    set_period(0); // Event-driven: door events and magnet timeouts arrive as messages
     frontDoorReleased = false;
     topDoorReleased = false;
     frontDoorOpened = false;
     topDoorOpened = false;
     waitingForDoorOpen = false;
     lastLEDState = false; // false = locked, true = unlocked
-    frontDoorOpenTime = 0;
-    topDoorOpenTime = 0;
-    frontDoorCloseTime = 0;
-    topDoorCloseTime = 0;
-    frontDoorNeedsReengage = false;
-    topDoorNeedsReengage = false;
+    frontMagnetTimer = TIMER_NONE;
+    topMagnetTimer = TIMER_NONE;
+    frontReengageTimer = TIMER_NONE;
+    topReengageTimer = TIMER_NONE;
     unauthorizedAccessActive = false;
 }
 
@@ -55,56 +53,54 @@ void DoorControlTask::on_msg(const MsgData& msg) {
             handleDoorSensorEvent(msg.type);
             break;
             
+        // Delayed messages scheduled by this task
+        case EVT_DOOR_FRONT_MAGNET_DELAY:
+        case EVT_DOOR_TOP_MAGNET_DELAY:
+        case EVT_DOOR_FRONT_REENGAGE:
+        case EVT_DOOR_TOP_REENGAGE:
+            handleDoorTimeout(msg.type);
+            break;
+            
         default:
             break;
     }
 }
 
 void DoorControlTask::step() {
-    // Check for magnet delay timing
-    unsigned long currentTime = OS.now();
-    
-    // Check if front door delay has passed - now re-engage magnet (turn back to LOW)
-    if (frontDoorOpened && frontDoorReleased && frontDoorOpenTime > 0) {
-        if (currentTime - frontDoorOpenTime >= MAGNET_DELAY_MS) {
-            digitalWrite(FRONT_DOOR_PIN, LOW); // Re-engage magnet after 1.5s delay
-            log_info(F("Front door magnet re-engaged after 1.5s delay"));
-            frontDoorOpenTime = 0; // Reset to avoid repeated messages
-        }
-    }
-    
-    // Check if top door delay has passed - now re-engage magnet (turn back to LOW)
-    if (topDoorOpened && topDoorReleased && topDoorOpenTime > 0) {
-        if (currentTime - topDoorOpenTime >= MAGNET_DELAY_MS) {
-            digitalWrite(TOP_DOOR_PIN, LOW); // Re-engage magnet after 1.5s delay
-            log_info(F("Top door magnet re-engaged after 1.5s delay"));
-            topDoorOpenTime = 0; // Reset to avoid repeated messages
-        }
-    }
-    
-    // Check for magnet re-engagement delays
-    if (frontDoorNeedsReengage && frontDoorCloseTime > 0) {
-        if (currentTime - frontDoorCloseTime >= REENGAGE_DELAY_MS) {
+    // Runs after each delivered message: update status LEDs based on door state
+    updateStatusLEDs();
+}
+
+void DoorControlTask::handleDoorTimeout(uint8_t eventType) {
+    switch (eventType) {
+        case EVT_DOOR_FRONT_MAGNET_DELAY:
+            frontMagnetTimer = TIMER_NONE;
+            if (frontDoorOpened && frontDoorReleased) {
+                digitalWrite(FRONT_DOOR_PIN, LOW); // Re-engage magnet after 1.5s delay
+                log_info(F("Front door magnet re-engaged after 1.5s delay"));
+            }
+            break;
+            
+        case EVT_DOOR_TOP_MAGNET_DELAY:
+            topMagnetTimer = TIMER_NONE;
+            if (topDoorOpened && topDoorReleased) {
+                digitalWrite(TOP_DOOR_PIN, LOW); // Re-engage magnet after 1.5s delay
+                log_info(F("Top door magnet re-engaged after 1.5s delay"));
+            }
+            break;
+            
+        case EVT_DOOR_FRONT_REENGAGE:
+            frontReengageTimer = TIMER_NONE;
             digitalWrite(FRONT_DOOR_PIN, LOW); // Re-engage magnet
-            frontDoorNeedsReengage = false;
-            frontDoorCloseTime = 0;
             log_info(F("Front door magnet re-engaged after delay"));
-        }
-    }
-    
-    if (topDoorNeedsReengage && topDoorCloseTime > 0) {
-        if (currentTime - topDoorCloseTime >= REENGAGE_DELAY_MS) {
+            break;
+            
+        case EVT_DOOR_TOP_REENGAGE:
+            topReengageTimer = TIMER_NONE;
             digitalWrite(TOP_DOOR_PIN, LOW); // Re-engage magnet
-            topDoorNeedsReengage = false;
-            topDoorCloseTime = 0;
             log_info(F("Top door magnet re-engaged after delay"));
-        }
+            break;
     }
-    
-    // Update status LEDs based on door state
-    updateStatusLEDs();
-    
-    // Process any received messages
 }
 
 void DoorControlTask::releaseFrontDoor() {
@@ -182,8 +178,12 @@ void DoorControlTask::handleDoorSensorEvent(uint8_t eventType) {
     switch (eventType) {
         case EVT_DOOR_FRONT_OPENED:
             frontDoorOpened = true;
-            frontDoorOpenTime = OS.now(); // Record time when door was opened
             if (frontDoorReleased) {
+                cancel_timer(frontMagnetTimer);
+                frontMagnetTimer = tell_after(MAGNET_DELAY_MS, get_id(), EVT_DOOR_FRONT_MAGNET_DELAY);
+                if (frontMagnetTimer == TIMER_NONE) {
+                    digitalWrite(FRONT_DOOR_PIN, LOW); // No timer available - fail safe, re-engage now
+                }
                 log_info(F("Front door opened - waiting 1.5s before turning off magnet"));
             } else {
                 // Unauthorized access - door opened without password
@@ -195,8 +195,12 @@ void DoorControlTask::handleDoorSensorEvent(uint8_t eventType) {
             
         case EVT_DOOR_TOP_OPENED:
             topDoorOpened = true;
-            topDoorOpenTime = OS.now(); // Record time when door was opened
             if (topDoorReleased) {
+                cancel_timer(topMagnetTimer);
+                topMagnetTimer = tell_after(MAGNET_DELAY_MS, get_id(), EVT_DOOR_TOP_MAGNET_DELAY);
+                if (topMagnetTimer == TIMER_NONE) {
+                    digitalWrite(TOP_DOOR_PIN, LOW); // No timer available - fail safe, re-engage now
+                }
                 log_info(F("Top door opened - waiting 1.5s before turning off magnet"));
             } else {
                 // Unauthorized access - door opened without password
@@ -208,7 +212,7 @@ void DoorControlTask::handleDoorSensorEvent(uint8_t eventType) {
             
         case EVT_DOOR_FRONT_CLOSED:
             frontDoorOpened = false;
-            frontDoorOpenTime = 0; // Reset timing
+            cancel_timer(frontMagnetTimer); // Door closed before the magnet delay ran out
             // Stop angry sound when door is closed (only if unauthorized access was active)
             if (unauthorizedAccessActive) {
                 publish(TOPIC_BUZZER_EVENTS, EVT_BUZZER_ANGRY_SOUND_STOP, 0, nullptr);
@@ -216,16 +220,19 @@ void DoorControlTask::handleDoorSensorEvent(uint8_t eventType) {
                 log_info(F("Front door closed - stopping angry sound"));
             }
             if (frontDoorReleased) {
-                // Front door is closed - schedule magnet re-engagement
-                frontDoorCloseTime = OS.now(); // Record when door was closed
-                frontDoorNeedsReengage = true; // Flag to re-engage magnet
+                // Front door is closed - schedule magnet re-engagement (one pending per door)
+                cancel_timer(frontReengageTimer);
+                frontReengageTimer = tell_after(REENGAGE_DELAY_MS, get_id(), EVT_DOOR_FRONT_REENGAGE);
+                if (frontReengageTimer == TIMER_NONE) {
+                    digitalWrite(FRONT_DOOR_PIN, LOW); // No timer available - re-engage now
+                }
                 log_info(F("Front door closed - magnet will re-engage in 100ms"));
             }
             break;
             
         case EVT_DOOR_TOP_CLOSED:
             topDoorOpened = false;
-            topDoorOpenTime = 0; // Reset timing
+            cancel_timer(topMagnetTimer); // Door closed before the magnet delay ran out
             // Stop angry sound when door is closed (only if unauthorized access was active)
             if (unauthorizedAccessActive) {
                 publish(TOPIC_BUZZER_EVENTS, EVT_BUZZER_ANGRY_SOUND_STOP, 0, nullptr);
@@ -233,9 +240,12 @@ void DoorControlTask::handleDoorSensorEvent(uint8_t eventType) {
                 log_info(F("Top door closed - stopping angry sound"));
             }
             if (topDoorReleased) {
-                // Top door is closed - schedule magnet re-engagement
-                topDoorCloseTime = OS.now(); // Record when door was closed
-                topDoorNeedsReengage = true; // Flag to re-engage magnet
+                // Top door is closed - schedule magnet re-engagement (one pending per door)
+                cancel_timer(topReengageTimer);
+                topReengageTimer = tell_after(REENGAGE_DELAY_MS, get_id(), EVT_DOOR_TOP_REENGAGE);
+                if (topReengageTimer == TIMER_NONE) {
+                    digitalWrite(TOP_DOOR_PIN, LOW); // No timer available - re-engage now
+                }
                 log_info(F("Top door closed - magnet will re-engage in 100ms"));
             }
             break;
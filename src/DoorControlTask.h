@@ -19,12 +19,10 @@ private:
     uint8_t topDoorOpened:1;   // Track if top door is physically opened
     uint8_t waitingForDoorOpen:1; // Track if we're waiting for door to be opened
     uint8_t lastLEDState:1; // Track last LED state to avoid duplicate messages
-    unsigned long frontDoorOpenTime; // Time when front door was opened
-    unsigned long topDoorOpenTime;   // Time when top door was opened
-    unsigned long frontDoorCloseTime; // Time when front door was closed
-    unsigned long topDoorCloseTime;   // Time when top door was closed
-    uint8_t frontDoorNeedsReengage:1; // Flag to re-engage front door magnet
-    uint8_t topDoorNeedsReengage:1;   // Flag to re-engage top door magnet
+    TimerHandle frontMagnetTimer; // Pending 1.5s magnet delay after front door opened
+    TimerHandle topMagnetTimer;   // Pending 1.5s magnet delay after top door opened
+    TimerHandle frontReengageTimer; // Pending 100ms re-engage after front door closed
+    TimerHandle topReengageTimer;   // Pending 100ms re-engage after top door closed
     uint8_t unauthorizedAccessActive:1; // Flag to track if angry sound is playing
     static const unsigned long MAGNET_DELAY_MS = 1500; // 1.5 second delay
     static const unsigned long REENGAGE_DELAY_MS = 100; // 100ms delay for re-engagement
@@ -35,4 +33,5 @@ private:
     void lockAllDoors();
     void updateStatusLEDs();
     void handleDoorSensorEvent(uint8_t eventType);
+    void handleDoorTimeout(uint8_t eventType);
 };
@@ -1,12 +1,12 @@
 #include "DoorSensorTask.h"
 
 DoorSensorTask::DoorSensorTask() {
-    set_period(50); // Check every 50ms for responsive door detection
+    set_period(0); // Event-driven: woken by pin-change edges on the sensors
     frontDoorState = false;
     topDoorState = false;
     lastFrontDoorState = false;
     lastTopDoorState = false;
-    lastDebounceTime = 0;
+    settling = false;
 }
 
 void DoorSensorTask::on_start() {
@@ -14,6 +14,11 @@ void DoorSensorTask::on_start() {
     pinMode(FRONT_DOOR_SENSOR_PIN, INPUT_PULLUP);
     pinMode(TOP_DOOR_SENSOR_PIN, INPUT_PULLUP);
     
+    // Get an EVT_PIN_CHANGE message on every sensor edge
+    PinChangeInput::watch(FRONT_DOOR_SENSOR_PIN, TOPIC_PIN_CHANGE_PORT_B, EVT_PIN_CHANGE);
+    PinChangeInput::watch(TOP_DOOR_SENSOR_PIN, TOPIC_PIN_CHANGE_PORT_B, EVT_PIN_CHANGE);
+    subscribe(TOPIC_PIN_CHANGE_PORT_B);
+    
     // Read initial states
     readDoorSensors();
     lastFrontDoorState = frontDoorState;
@@ -24,16 +29,44 @@ void DoorSensorTask::on_start() {
 }
 
 void DoorSensorTask::on_msg(const MsgData& msg) {
-    // Door sensor task doesn't need to handle incoming messages
-    // It only publishes door state changes
+    switch (msg.type) {
+        case EVT_PIN_CHANGE:
+            // Report the first edge at once, then ignore contact bounce until it settles
+            if (!settling) {
+                publishDoorEvents();
+                startSettle();
+            }
+            break;
+            
+        case EVT_DOOR_SENSOR_SETTLE:
+            settling = false;
+            // A change that happened while settling is reported now
+            if (publishDoorEvents()) {
+                startSettle();
+            }
+            break;
+            
+        default:
+            break;
+    }
 }
 
 void DoorSensorTask::step() {
+    // Nothing to poll: sensor edges arrive as EVT_PIN_CHANGE messages
+}
+
+void DoorSensorTask::startSettle() {
+    settling = (tell_after(SENSOR_DEBOUNCE_TIME_MS, get_id(), EVT_DOOR_SENSOR_SETTLE) != TIMER_NONE);
+}
+
+bool DoorSensorTask::publishDoorEvents() {
     readDoorSensors();
+    bool changed = false;
     
     // Check for state changes and publish events
     if (frontDoorState != lastFrontDoorState) {
         lastFrontDoorState = frontDoorState;
+        changed = true;
         
         if (frontDoorState) {
             // Front door opened (sensor reads LOW/GND)
@@ -48,6 +81,7 @@ void DoorSensorTask::step() {
     
     if (topDoorState != lastTopDoorState) {
         lastTopDoorState = topDoorState;
+        changed = true;
         
         if (topDoorState) {
             // Top door opened (sensor reads LOW/GND when closed, so HIGH when opened)
@@ -59,6 +93,8 @@ void DoorSensorTask::step() {
             log_info(F("Top door closed"));
         }
     }
+    
+    return changed;
 }
 
 void DoorSensorTask::readDoorSensors() {
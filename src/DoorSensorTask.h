@@ -16,9 +16,10 @@ private:
     uint8_t topDoorState:1;
     uint8_t lastFrontDoorState:1;
     uint8_t lastTopDoorState:1;
-    unsigned long lastDebounceTime;
+    uint8_t settling:1; // Edges are ignored until the settle timeout
     static const unsigned long SENSOR_DEBOUNCE_TIME_MS = 50;
     
     void readDoorSensors();
-    void publishDoorEvents();
+    bool publishDoorEvents();
+    void startSettle();
 };
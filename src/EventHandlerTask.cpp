@@ -1,7 +1,7 @@
 #include "EventHandlerTask.h"
 
 EventHandlerTask::EventHandlerTask() : Task(nullptr) {
-    set_period(100); // Check for messages every 100ms
+    set_period(0); // Event-driven: only runs when a message arrives
     isDimming = false;
 }
 
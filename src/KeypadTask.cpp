@@ -1,7 +1,7 @@
 #include "KeypadTask.h"
 
 KeypadTask::KeypadTask() : Task(nullptr) {
-    set_period(10); // Check keypad every 10ms for responsive debouncing
+    set_period(0); // Event-driven: woken by key edges and long-press timeouts
 }
 
 void KeypadTask::on_start() {
@@ -11,6 +11,13 @@ void KeypadTask::on_start() {
     pinMode(KEYPAD_PIN_3, INPUT_PULLUP);
     pinMode(KEYPAD_PIN_4, INPUT_PULLUP);
     
+    // Get an EVT_PIN_CHANGE message on every key edge
+    PinChangeInput::watch(KEYPAD_PIN_1, TOPIC_PIN_CHANGE_PORT_D, EVT_PIN_CHANGE);
+    PinChangeInput::watch(KEYPAD_PIN_2, TOPIC_PIN_CHANGE_PORT_D, EVT_PIN_CHANGE);
+    PinChangeInput::watch(KEYPAD_PIN_3, TOPIC_PIN_CHANGE_PORT_D, EVT_PIN_CHANGE);
+    PinChangeInput::watch(KEYPAD_PIN_4, TOPIC_PIN_CHANGE_PORT_D, EVT_PIN_CHANGE);
+    subscribe(TOPIC_PIN_CHANGE_PORT_D);
+    
     // Initialize key states
     for (uint8_t i = 0; i < 4; i++) {
         keys[i].lastState = HIGH;
@@ -18,12 +25,29 @@ void KeypadTask::on_start() {
         keys[i].lastPressTime = 0;
         keys[i].debounced = false;
         keys[i].longReported = false;
+        keys[i].longPressTimer = TIMER_NONE;
     }
     
     log_info(F("Task started - 4-digit keypad (1,2,3,4)"));
 }
 
+void KeypadTask::on_msg(const MsgData& msg) {
+    switch (msg.type) {
+        case EVT_PIN_CHANGE:              // Edge on port D (keys share it with other inputs)
+        case EVT_KEYPAD_LONG_PRESS_CHECK: // A key has been held for LONG_PRESS_TIME_MS
+            checkKeys();
+            break;
+            
+        default:
+            break;
+    }
+}
+
 void KeypadTask::step() {
+    // Nothing to poll: key edges arrive as EVT_PIN_CHANGE messages
+}
+
+void KeypadTask::checkKeys() {
     // Check each key
     checkKey(0, KEYPAD_PIN_1, EVT_KEYPAD_1_PRESSED);
     checkKey(1, KEYPAD_PIN_2, EVT_KEYPAD_2_PRESSED);
@@ -40,11 +64,15 @@ void KeypadTask::checkKey(uint8_t keyIndex, uint8_t pin, uint8_t eventType) {
         keys[keyIndex].lastPressTime = OS.now();
         keys[keyIndex].debounced = false;
         keys[keyIndex].longReported = false;
+        // Come back when the press becomes a long press
+        cancel_timer(keys[keyIndex].longPressTimer);
+        keys[keyIndex].longPressTimer = tell_after(LONG_PRESS_TIME_MS, get_id(), EVT_KEYPAD_LONG_PRESS_CHECK, keyIndex);
         log_debugf(F("Key %u press detected"), keyIndex + 1);
     }
     // Detect key release
     else if (keys[keyIndex].currentState == HIGH && keys[keyIndex].lastState == LOW) {
         // Key just released
+        cancel_timer(keys[keyIndex].longPressTimer);
         if (!keys[keyIndex].debounced) {
             unsigned long pressDuration = OS.now() - keys[keyIndex].lastPressTime;
             
@@ -9,6 +9,7 @@ public:
     KeypadTask();
     
     void on_start() override;
+    void on_msg(const MsgData& msg) override;
     void step() override;
     
 private:
@@ -18,10 +19,12 @@ private:
         unsigned long lastPressTime;
         uint8_t debounced:1;
         uint8_t longReported:1;
+        TimerHandle longPressTimer; // Pending EVT_KEYPAD_LONG_PRESS_CHECK
     };
     
     KeyState keys[4]; // For keys 1, 2, 3, 4
     
+    void checkKeys();
     void checkKey(uint8_t keyIndex, uint8_t pin, uint8_t eventType);
     void handleKeyPress(uint8_t keyIndex, uint8_t eventType);
     void handleKeyLongPress(uint8_t keyIndex, uint8_t eventType);
@@ -3,6 +3,10 @@
 void MBLightSensorTask::on_start() {
     pinMode(MB_LIGHT_SENSOR_PIN, INPUT_PULLUP);
     
+    // Get an EVT_PIN_CHANGE message on every sensor edge
+    PinChangeInput::watch(MB_LIGHT_SENSOR_PIN, TOPIC_PIN_CHANGE_PORT_D, EVT_PIN_CHANGE);
+    subscribe(TOPIC_PIN_CHANGE_PORT_D);
+    
     log_info(F("Task started - Pin=D7"));
     log_info(F("Monitors motherboard light sensor state"));
     
@@ -15,14 +19,14 @@ void MBLightSensorTask::on_start() {
 }
 
 void MBLightSensorTask::step() {
-    readMBLightSensor();
-    
-    // Process any received messages
+    // Nothing to poll: sensor edges arrive as EVT_PIN_CHANGE messages
 }
 
 void MBLightSensorTask::on_msg(const MsgData& msg) {
-    // This task doesn't handle incoming messages
-    (void)msg;
+    // Port D is shared with the keypad and yellow button
+    if (msg.type == EVT_PIN_CHANGE && PinChangeInput::changed(msg, MB_LIGHT_SENSOR_PIN)) {
+        readMBLightSensor();
+    }
 }
 
 void MBLightSensorTask::readMBLightSensor() {
@@ -6,7 +6,7 @@
 class MBLightSensorTask : public Task {
 public:
     MBLightSensorTask() {
-        set_period(100); // Check every 100ms
+        set_period(0); // Event-driven: woken by pin-change edges on the sensor
     }
 
 protected:
@@ -1,11 +1,12 @@
 #include "PasswordManagerTask.h"
 
 PasswordManagerTask::PasswordManagerTask() : Task(nullptr) {
-    set_period(100); // Check every 100ms
+    set_period(0); // Event-driven: the entry timeout arrives as a delayed message
     currentState = PASSWORD_IDLE;
     enteredPassword[0] = '\0'; // Initialize as empty string
     strcpy(correctPassword, DEFAULT_PASSWORD);
     lastDigitTime = 0;
+    timeoutTimer = TIMER_NONE;
     digitCount = 0;
 }
 
@@ -46,7 +47,7 @@ void PasswordManagerTask::on_msg(const MsgData& msg) {
                 enteredPassword[digitCount] = '0' + digit;
                 enteredPassword[digitCount + 1] = '\0';
                 digitCount++;
-                lastDigitTime = OS.now();
+                restartTimeout();
                 
                 if (currentState == PASSWORD_IDLE) {
                     currentState = PASSWORD_ENTERING;
@@ -93,34 +94,48 @@ void PasswordManagerTask::on_msg(const MsgData& msg) {
             }
             break;
             
+        case EVT_PASSWORD_TIMEOUT:
+            handleTimeout();
+            break;
+            
         default:
             break;
     }
 }
 
 void PasswordManagerTask::step() {
-    // Check for timeout
+    // Nothing to poll: entry timeouts are driven by EVT_PASSWORD_TIMEOUT
+}
+
+void PasswordManagerTask::restartTimeout() {
+    lastDigitTime = OS.now();
+    cancel_timer(timeoutTimer);
+    timeoutTimer = tell_after(PASSWORD_DIGIT_TIMEOUT_MS, get_id(), EVT_PASSWORD_TIMEOUT);
+}
+
+void PasswordManagerTask::handleTimeout() {
+    // A timeout that fired just before a new digit can still be queued, so check elapsed time
     unsigned long currentTime = OS.now();
     
     if (currentState == PASSWORD_ENTERING || currentState == PASSWORD_CHANGE_ENTER || currentState == PASSWORD_CHANGE_CONFIRM) {
-        if (currentTime - lastDigitTime > PASSWORD_DIGIT_TIMEOUT_MS) {
+        if (currentTime - lastDigitTime >= PASSWORD_DIGIT_TIMEOUT_MS) {
             log_warn(F("Timeout - clearing entered password"));
             resetPassword();
         }
     }
     else if (currentState == PASSWORD_WAITING_DOOR_SELECTION) {
-        if (currentTime - lastDigitTime > PASSWORD_DIGIT_TIMEOUT_MS) {
+        if (currentTime - lastDigitTime >= PASSWORD_DIGIT_TIMEOUT_MS) {
             log_warn(F("Timeout - no option selected, resetting"));
             resetPassword();
         }
     }
-    
 }
 
 void PasswordManagerTask::resetPassword() {
     enteredPassword[0] = '\0';
     digitCount = 0;
     currentState = PASSWORD_IDLE;
+    cancel_timer(timeoutTimer);
     log_info(F("Reset to idle state"));
 }
 
@@ -140,7 +155,7 @@ void PasswordManagerTask::checkPassword() {
         
         // Wait for door selection
         currentState = PASSWORD_WAITING_DOOR_SELECTION;
-        lastDigitTime = OS.now(); // Reset timeout for door selection
+        restartTimeout(); // Reset timeout for door selection
     } else {
         log_warn(F("WRONG - no action taken"));
         
@@ -208,7 +223,7 @@ void PasswordManagerTask::handleYellowShortPress() {
 void PasswordManagerTask::resetEntryBuffer() {
     enteredPassword[0] = '\0';
     digitCount = 0;
-    lastDigitTime = OS.now();
+    restartTimeout();
 }
 
 void PasswordManagerTask::loadPasswordFromEEPROM() {
@@ -28,8 +28,11 @@ private:
     char correctPassword[PASSWORD_LENGTH + 1];
     char newPasswordBuffer[PASSWORD_LENGTH + 1];
     unsigned long lastDigitTime;
+    TimerHandle timeoutTimer; // pending EVT_PASSWORD_TIMEOUT
     uint8_t digitCount;
     
+    void restartTimeout();
+    void handleTimeout();
     void resetPassword();
     void checkPassword();
     void handleDoorSelection(uint8_t digit);
@@ -25,6 +25,27 @@ static bool startsWithIgnoreCase_P(const char* ram, PGM_P rom) {
     }
 }
 
+// Log level names as used by the "loglevel" command
+static bool parseLogLevel(const char* name, LogLevel& level) {
+    if (equalsIgnoreCase_P(name, PSTR("debug"))) level = LOG_DEBUG;
+    else if (equalsIgnoreCase_P(name, PSTR("info"))) level = LOG_INFO;
+    else if (equalsIgnoreCase_P(name, PSTR("warn"))) level = LOG_WARNING;
+    else if (equalsIgnoreCase_P(name, PSTR("error"))) level = LOG_ERROR;
+    else if (equalsIgnoreCase_P(name, PSTR("none"))) level = LOG_NONE;
+    else return false;
+    return true;
+}
+
+static void printLogLevelName(LogLevel level) {
+    switch (level) {
+        case LOG_DEBUG:   Serial.print(F("debug")); break;
+        case LOG_INFO:    Serial.print(F("info")); break;
+        case LOG_WARNING: Serial.print(F("warn")); break;
+        case LOG_ERROR:   Serial.print(F("error")); break;
+        default:          Serial.print(F("none")); break;
+    }
+}
+
 SerialCommandTask::SerialCommandTask() {
     set_period(50); // Check for serial input every 50ms
     inputLen = 0;
@@ -62,6 +83,8 @@ void SerialCommandTask::step() {
 }
 
 void SerialCommandTask::processCommand(const char* command) {
+    // Finish buffered log lines so the reply does not split one
+    OS.flush_log();
     Serial.print(F("> "));
     Serial.println(command);
     
@@ -71,9 +94,29 @@ void SerialCommandTask::processCommand(const char* command) {
     else if (equalsIgnoreCase_P(command, PSTR("stats")) || equalsIgnoreCase_P(command, PSTR("s"))) {
         printTaskStats();
     }
+    else if (equalsIgnoreCase_P(command, PSTR("stats reset"))) {
+        OS.reset_task_stats();
+        Serial.println(F("Task statistics reset"));
+    }
+    else if (equalsIgnoreCase_P(command, PSTR("topics"))) {
+        printTopicStats();
+    }
+#if FSMOS_TOPIC_STATS
+    else if (equalsIgnoreCase_P(command, PSTR("topics reset"))) {
+        OS.reset_topic_stats();
+        Serial.println(F("Topic statistics reset"));
+    }
+#endif
     else if (equalsIgnoreCase_P(command, PSTR("reset")) || equalsIgnoreCase_P(command, PSTR("r"))) {
         printResetInfo();
     }
+    else if (equalsIgnoreCase_P(command, PSTR("trace"))) {
+        printTrace();
+    }
+    else if (equalsIgnoreCase_P(command, PSTR("trace clear"))) {
+        OS.restart_trace();
+        Serial.println(F("Trace cleared, recording"));
+    }
     else if (equalsIgnoreCase_P(command, PSTR("uptime")) || equalsIgnoreCase_P(command, PSTR("u"))) {
         printUptime();
     }
@@ -104,6 +147,15 @@ void SerialCommandTask::processCommand(const char* command) {
     else if (equalsIgnoreCase_P(command, PSTR("memory")) || equalsIgnoreCase_P(command, PSTR("mem"))) {
         handleMemoryInfo();
     }
+    else if (equalsIgnoreCase_P(command, PSTR("heap"))) {
+        handleHeapInfo();
+    }
+    else if (equalsIgnoreCase_P(command, PSTR("loglevel"))) {
+        printLogLevels();
+    }
+    else if (startsWithIgnoreCase_P(command, PSTR("loglevel "))) {
+        handleLogLevelCommand(command + 9);
+    }
     else if (equalsIgnoreCase_P(command, PSTR("test")) || equalsIgnoreCase_P(command, PSTR("t"))) {
         handleKeypadTest();
     }
@@ -122,7 +174,12 @@ void SerialCommandTask::printHelp() {
     Serial.println(F("=== Available Commands ==="));
     Serial.println(F("help, h          - Show this help"));
     Serial.println(F("stats, s         - Show task statistics"));
+    Serial.println(F("stats reset      - Start a new statistics window"));
+    Serial.println(F("topics           - Show per-topic traffic and bus latency (CSV)"));
+    Serial.println(F("topics reset     - Clear topic statistics"));
     Serial.println(F("reset, r         - Show reset information"));
+    Serial.println(F("trace            - Dump the flight recorder (decode with trace_decode.py)"));
+    Serial.println(F("trace clear      - Clear the flight recorder and resume recording"));
     Serial.println(F("uptime, u        - Show system uptime"));
     Serial.println(F("status, st       - Show system status"));
     Serial.println(F("led <state>      - Control LEDs (locked/unlocked/to_be_locked)"));
@@ -133,6 +190,9 @@ void SerialCommandTask::printHelp() {
     Serial.println(F("factoryreset     - Reset EEPROM and defaults (DANGEROUS)"));
     Serial.println(F("sensors          - Show sensor status"));
     Serial.println(F("memory, mem      - Show memory usage information"));
+    Serial.println(F("heap             - Show heap free list and change since last 'heap'"));
+    Serial.println(F("loglevel         - Show each task's log level"));
+    Serial.println(F("loglevel <task|all> <lvl> - Set log level (debug/info/warn/error/none)"));
     Serial.println(F("test, t          - Test keypad and button"));
     Serial.println(F("buzzer, b        - Test buzzer sounds"));
     Serial.println(F("clear, c         - Clear screen"));
@@ -158,32 +218,110 @@ void SerialCommandTask::printTaskStats() {
     Serial.print(F("=== Task Statistics ===\n"));
     Serial.print(F("Total tasks: "));
     Serial.println(taskCount);
+
+    IdleStats idle;
+    OS.get_idle_stats(idle);
+    Serial.print(F("CPU idle: "));
+    Serial.print(idle.idle_percent);
+    Serial.print(F("% ("));
+    Serial.print(idle.idle_ms);
+    Serial.print(F("/"));
+    Serial.print(idle.window_ms);
+    Serial.println(F("ms)"));
     
-    for (uint8_t i = 0; i < taskCount; i++) {
+    uint8_t cursor = 0;
+    while (Task* task = OS.next_task(cursor)) {
         TaskStats stats;
-        if (OS.get_task_stats(i, stats)) {
-            Task* task = OS.get_task(i);
-            if (task) {
-                Serial.print(F("Task "));
-                Serial.print(i);
-                Serial.print(F(" ("));
-                Serial.print(task->get_name());
-                Serial.print(F("): Runs="));
-                Serial.print(stats.run_count);
-                Serial.print(F(", MaxTime="));
-                Serial.print(stats.max_exec_time_us);
-                Serial.print(F("us, AvgTime="));
-                if (stats.run_count > 0) {
-                    Serial.print(stats.total_exec_time_us / stats.run_count);
-                } else {
-                    Serial.print(0);
-                }
-                Serial.print(F("us, Period="));
-                Serial.print(task->get_period());
-                Serial.println(F("ms"));
+        if (OS.get_task_stats(task->get_id(), stats)) {
+            Serial.print(F("Task "));
+            Serial.print(task->get_id());
+            Serial.print(F(" ("));
+            Serial.print(task->get_name());
+            Serial.print(F("): Runs="));
+            Serial.print(stats.run_count);
+            Serial.print(F(", MaxTime="));
+            Serial.print(stats.max_exec_time_us);
+            Serial.print(F("us, AvgTime="));
+            if (stats.run_count > 0) {
+                Serial.print(stats.total_exec_time_us / stats.run_count);
+            } else {
+                Serial.print(0);
             }
+            Serial.print(F("us, MaxLate="));
+            Serial.print(stats.max_lateness_ms);
+            Serial.print(F("ms, Missed="));
+            Serial.print(stats.missed_deadlines);
+            Serial.print(F(", Period="));
+            Serial.print(task->get_period());
+            Serial.println(F("ms"));
+#if FSMOS_STATS_BUCKETS > 0
+            printHistogram(stats, false);
+            printHistogram(stats, true);
+#endif
+        }
+    }
+}
+
+#if FSMOS_STATS_BUCKETS > 0
+void SerialCommandTask::printHistogram(const TaskStats& stats, bool lateness) {
+    uint8_t shift = lateness ? Scheduler::LATE_HIST_SHIFT : Scheduler::EXEC_HIST_SHIFT;
+    Serial.print(lateness ? F("  Late ms:") : F("  Exec us:"));
+    for (uint8_t b = 0; b < FSMOS_STATS_BUCKETS; b++) {
+        // Bucket b holds values below (1 << shift) << 2b, the last one everything above
+        if (b < FSMOS_STATS_BUCKETS - 1) {
+            Serial.print(F(" <"));
+            Serial.print((1UL << shift) << (2 * b));
+        } else {
+            Serial.print(F(" >="));
+            Serial.print(b ? (1UL << shift) << (2 * (b - 1)) : 0);
         }
+        Serial.print(':');
+        Serial.print(lateness ? stats.late_hist[b] : stats.exec_hist[b]);
     }
+    Serial.println();
+}
+#endif
+
+/**
+ * One CSV row per topic that saw traffic, so the dump can be pasted into
+ * a spreadsheet. bus_pct is the topic's share of all delivery time.
+ */
+void SerialCommandTask::printTopicStats() {
+#if FSMOS_TOPIC_STATS
+    Serial.println(F("=== Topic Statistics ==="));
+    Serial.println(F("topic,posted,dropped,delivered,recipients,avg_lat_us,max_lat_us,bus_us,bus_pct"));
+
+    TopicStats stats;
+    uint32_t total_bus_us = 0;
+    for (uint16_t topic = 0; topic < FSMOS_MAX_TOPICS; topic++) {
+        if (OS.get_topic_stats(topic, stats)) total_bus_us += stats.bus_us;
+    }
+
+    for (uint16_t topic = 0; topic < FSMOS_MAX_TOPICS; topic++) {
+        if (!OS.get_topic_stats(topic, stats)) continue;
+        if (!stats.posted && !stats.dropped && !stats.delivered) continue;
+        Serial.print(topic);
+        Serial.print(',');
+        Serial.print(stats.posted);
+        Serial.print(',');
+        Serial.print(stats.dropped);
+        Serial.print(',');
+        Serial.print(stats.delivered);
+        Serial.print(',');
+        Serial.print(stats.recipients);
+        Serial.print(',');
+        Serial.print(stats.delivered ? stats.total_latency_us / stats.delivered : 0);
+        Serial.print(',');
+        Serial.print(stats.max_latency_us);
+        Serial.print(',');
+        Serial.print(stats.bus_us);
+        Serial.print(',');
+        // Divide by total/100 rather than multiplying bus_us, which could overflow
+        Serial.println(total_bus_us >= 100 ? stats.bus_us / (total_bus_us / 100) : 0);
+    }
+#else
+    Serial.println(F("Topic statistics disabled (build with -DFSMOS_TOPIC_STATS=1)"));
+#endif
 }
 
 void SerialCommandTask::printResetInfo() {
@@ -193,7 +331,31 @@ void SerialCommandTask::printResetInfo() {
         Serial.print(F("Reset Reason: "));
         Serial.print(resetInfo.reset_reason);
         Serial.print(F(", Last task: "));
-        Serial.println(resetInfo.last_task_id);
+        Serial.print(resetInfo.last_task_id);
+        Serial.print(F(", Trace events: "));
+        Serial.println(resetInfo.trace_count);
+    }
+}
+
+/**
+ * Raw records, oldest first: TR,event,time_ms,id,arg. The host decoder
+ * in lib/FsmOS/extras turns them into a timeline.
+ */
+void SerialCommandTask::printTrace() {
+    Serial.print(F("=== Trace ("));
+    Serial.print(OS.is_trace_frozen() ? F("frozen at reset") : F("live"));
+    Serial.println(F(") ==="));
+
+    TraceRecord record;
+    for (uint8_t i = 0; OS.get_trace_record(i, record); i++) {
+        Serial.print(F("TR,"));
+        Serial.print((uint8_t)record.event());
+        Serial.print(',');
+        Serial.print(record.time_ms());
+        Serial.print(',');
+        Serial.print(record.id);
+        Serial.print(',');
+        Serial.println(record.arg);
     }
 }
 
@@ -502,6 +664,57 @@ void SerialCommandTask::handleMemoryInfo() {
         Serial.print(sys_info.message_memory);
         Serial.println(F(" bytes"));
         
+        // Message Pool
+        MsgPoolStats pool;
+        OS.get_msg_pool_stats(pool);
+        Serial.println(F("\nMessage Pool:"));
+        Serial.print(F("  In use:     "));
+        Serial.print(pool.in_use);
+        Serial.print('/');
+        Serial.println(pool.capacity);
+        Serial.print(F("  High water: "));
+        Serial.println(pool.high_water);
+        Serial.print(F("  Exhausted:  "));
+        Serial.println(pool.exhausted);
+        
+        // Message Bus
+        BusStats bus;
+        OS.get_bus_stats(bus);
+        Serial.println(F("\nMessage Bus:"));
+        Serial.print(F("  Pending:    "));
+        Serial.println(bus.pending);
+        Serial.print(F("  High water: "));
+        Serial.println(bus.high_water);
+        Serial.print(F("  Dropped:    "));
+        Serial.println(bus.dropped);
+        Serial.print(F("  Merged:     "));
+        Serial.println(bus.merged);
+        Serial.print(F("  Deferred:   "));
+        Serial.println(bus.deferred);
+        Serial.print(F("  Discarded:  "));
+        Serial.println(bus.discarded);
+        Serial.print(F("  Timers:     "));
+        Serial.print(OS.get_pending_timers());
+        Serial.print('/');
+        Serial.println(FSMOS_MAX_TIMERS);
+        
+#if FSMOS_LOG_BUFFER_SIZE
+        // Log Buffer
+        LogStats log;
+        OS.get_log_stats(log);
+        Serial.println(F("\nLog Buffer:"));
+        Serial.print(F("  Pending:    "));
+        Serial.print(log.pending);
+        Serial.print('/');
+        Serial.println(FSMOS_LOG_BUFFER_SIZE);
+        Serial.print(F("  High water: "));
+        Serial.println(log.high_water);
+        Serial.print(F("  Dropped:    "));
+        Serial.println(log.dropped);
+        Serial.print(F("  Truncated:  "));
+        Serial.println(log.truncated);
+        
+#endif
         // Flash Usage
         Serial.println(F("\nProgram Memory:"));
         Serial.print(F("  Used:  "));
@@ -519,27 +732,49 @@ void SerialCommandTask::handleMemoryInfo() {
         Serial.println(F("============"));
         
         // Print info for each task
-        for (uint8_t i = 0; i < OS.get_task_count(); i++) {
-            Task* task = OS.get_task(i);
-            if (task) {
-                TaskMemoryInfo task_info;
-                if (OS.get_task_memory_info(i, task_info)) {
-                    Serial.print(F("\nTask '"));
-                    Serial.print(task->get_name());
-                    Serial.println(F("':"));
-                    Serial.print(F("  Structure:    "));
-                    Serial.print(task_info.task_struct_size);
-                    Serial.println(F(" bytes"));
-                    Serial.print(F("  Subscriptions: "));
-                    Serial.print(task_info.subscription_size);
-                    Serial.println(F(" bytes"));
-                    Serial.print(F("  Queue:        "));
-                    Serial.print(task_info.queue_size);
-                    Serial.println(F(" bytes"));
-                    Serial.print(F("  Total:        "));
-                    Serial.print(task_info.total_allocated);
+        uint8_t cursor = 0;
+        while (Task* task = OS.next_task(cursor)) {
+            TaskMemoryInfo task_info;
+            if (OS.get_task_memory_info(task->get_id(), task_info)) {
+                Serial.print(F("\nTask '"));
+                Serial.print(task->get_name());
+                Serial.println(F("':"));
+                Serial.print(F("  Structure:    "));
+                Serial.print(task_info.task_struct_size);
+                Serial.println(F(" bytes"));
+                Serial.print(F("  Subscriptions: "));
+                Serial.print(task_info.subscription_size);
+                Serial.println(F(" bytes"));
+                Serial.print(F("  Queue:        "));
+                Serial.print(task_info.queue_size);
+                Serial.println(F(" bytes"));
+                MailboxStats mailbox;
+                if (OS.get_mailbox_stats(task->get_id(), mailbox)) {
+                    Serial.print(F("  Mailbox:      "));
+                    Serial.print(mailbox.pending);
+                    Serial.print(F(" queued, "));
+                    Serial.print(mailbox.dropped);
+                    Serial.println(F(" dropped"));
+                }
+                Serial.print(F("  Total:        "));
+                Serial.print(task_info.total_allocated);
+                Serial.println(F(" bytes"));
+                if (task_info.stack_peak) {
+                    Serial.print(F("  Stack peak:   "));
+                    Serial.print(task_info.stack_peak);
+                    Serial.print(F(" bytes, headroom "));
+                    Serial.print(task_info.stack_headroom);
                     Serial.println(F(" bytes"));
                 }
+                if (task_info.heap_allocs) {
+                    Serial.print(F("  Heap allocs:  "));
+                    Serial.print(task_info.heap_allocs);
+                    Serial.print(F(" ("));
+                    Serial.print(task_info.heap_bytes);
+                    Serial.print(F(" bytes), "));
+                    Serial.print(task_info.allocs_per_min);
+                    Serial.println(F("/min"));
+                }
             }
         }
     } else {
@@ -549,6 +784,98 @@ void SerialCommandTask::handleMemoryInfo() {
     Serial.println(F(""));
 }
 
+void SerialCommandTask::handleHeapInfo() {
+    HeapSnapshot heap;
+    OS.get_heap_snapshot(heap);
+
+    Serial.println(F("=== Heap ==="));
+    Serial.print(F("Size:        "));
+    Serial.print(heap.heap_size);
+    Serial.println(F(" bytes"));
+    Serial.print(F("Free list:   "));
+    Serial.print(heap.free_list_bytes);
+    Serial.print(F(" bytes in "));
+    Serial.print(heap.free_blocks);
+    Serial.print(F(" blocks, largest "));
+    Serial.println(heap.largest_free);
+    Serial.print(F("Unallocated: "));
+    Serial.print(heap.unallocated);
+    Serial.println(F(" bytes"));
+#if !defined(FSMOS_DISABLE_LEAK_DETECTION)
+    Serial.print(F("new/delete:  "));
+    Serial.print(fsmos_memory_stats.allocations);
+    Serial.print('/');
+    Serial.print(fsmos_memory_stats.deallocations);
+    Serial.print(F(", "));
+    Serial.print(fsmos_memory_stats.current_bytes);
+    Serial.print(F(" bytes live, peak "));
+    Serial.println(fsmos_memory_stats.peak_bytes);
+#endif
+
+    if (haveLastHeap) {
+        HeapSnapshot::Delta d = heap.diff(lastHeap);
+        Serial.print(F("Since last:  size "));
+        Serial.print(d.heap_size);
+        Serial.print(F(", free list "));
+        Serial.print(d.free_list_bytes);
+        Serial.print(F(" bytes / "));
+        Serial.print((int)d.free_blocks);
+        Serial.print(F(" blocks, largest "));
+        Serial.println(d.largest_free);
+    }
+    lastHeap = heap;
+    haveLastHeap = true;
+}
+
+void SerialCommandTask::printLogLevels() {
+    Serial.println(F("=== Log Levels ==="));
+    uint8_t cursor = 0;
+    while (Task* task = OS.next_task(cursor)) {
+        Serial.print(task->get_name());
+        Serial.print(F(": "));
+        printLogLevelName(task->get_log_level());
+        Serial.println();
+    }
+    Serial.print(F("Compiled in from: "));
+    printLogLevelName(FSMOS_LOG_LEVEL);
+    Serial.println();
+}
+
+void SerialCommandTask::handleLogLevelCommand(const char* args) {
+    while (*args == ' ') args++;
+    const char* levelArg = strrchr(args, ' ');
+    LogLevel level;
+    if (!levelArg || !parseLogLevel(levelArg + 1, level)) {
+        Serial.println(F("Usage: loglevel <task|all> <debug|info|warn|error|none>"));
+        return;
+    }
+
+    char name[MAX_BUFFER_SIZE];
+    size_t nameLen = levelArg - args;
+    memcpy(name, args, nameLen);
+    name[nameLen] = '\0';
+
+    bool all = equalsIgnoreCase_P(name, PSTR("all"));
+    uint8_t matched = 0;
+    uint8_t cursor = 0;
+    while (Task* task = OS.next_task(cursor)) {
+        if (all || equalsIgnoreCase_P(name, (PGM_P)task->get_name())) {
+            task->set_log_level(level);
+            matched++;
+        }
+    }
+    if (!matched) {
+        Serial.print(F("No task named '"));
+        Serial.print(name);
+        Serial.println('\'');
+        return;
+    }
+    if (level < FSMOS_LOG_LEVEL) {
+        Serial.println(F("Note: levels below the compiled-in level stay off"));
+    }
+    printLogLevels();
+}
+
 void SerialCommandTask::printUnknownCommand(const char* command) {
     Serial.print(F("Unknown command: '"));
     Serial.print(command);
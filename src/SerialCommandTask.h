@@ -15,11 +15,18 @@ private:
     static const size_t MAX_BUFFER_SIZE = 32;
     char inputBuffer[MAX_BUFFER_SIZE];
     size_t inputLen = 0;
+    HeapSnapshot lastHeap;       // Heap state at the previous "heap" command
+    bool haveLastHeap = false;
     
     void processCommand(const char* command);
     void printHelp();
     void printTaskStats();
+#if FSMOS_STATS_BUCKETS > 0
+    void printHistogram(const TaskStats& stats, bool lateness);
+#endif
+    void printTopicStats();
     void printResetInfo();
+    void printTrace();
     void printUptime();
     void printSystemStatus();
     void handleLEDCommand(const char* args);
@@ -32,5 +39,8 @@ private:
     void handleFactoryResetCommand();
     void handleSensorStatus();
     void handleMemoryInfo();
+    void handleHeapInfo();
+    void printLogLevels();
+    void handleLogLevelCommand(const char* args);
     void printUnknownCommand(const char* command);
 };
@@ -1,7 +1,7 @@
 #include "YellowButtonTask.h"
 
 YellowButtonTask::YellowButtonTask() {
-    set_period(10); // Check button every 10ms for responsive debouncing
+    set_period(0); // Event-driven: woken by button edges and the long-press timeout
 }
 
 void YellowButtonTask::on_start() {
@@ -10,10 +10,31 @@ void YellowButtonTask::on_start() {
     buttonPressed = false;
     pressStartTime = 0;
     longPressDetected = false;
+    longPressTimer = TIMER_NONE;
+    
+    // Get an EVT_PIN_CHANGE message on every button edge
+    PinChangeInput::watch(YELLOW_BUTTON_PIN, TOPIC_PIN_CHANGE_PORT_D, EVT_PIN_CHANGE);
+    subscribe(TOPIC_PIN_CHANGE_PORT_D);
     log_info(F("Task started"));
 }
 
+void YellowButtonTask::on_msg(const MsgData& msg) {
+    switch (msg.type) {
+        case EVT_PIN_CHANGE:              // Edge on port D (shared with other inputs)
+        case EVT_BUTTON_LONG_PRESS_CHECK: // Button has been held for LONG_PRESS_TIME_MS
+            checkButton();
+            break;
+            
+        default:
+            break;
+    }
+}
+
 void YellowButtonTask::step() {
+    // Nothing to poll: button edges arrive as EVT_PIN_CHANGE messages
+}
+
+void YellowButtonTask::checkButton() {
     bool currentButtonState = digitalRead(YELLOW_BUTTON_PIN);
     
     // Detect button press (active low due to INPUT_PULLUP)
@@ -22,11 +43,15 @@ void YellowButtonTask::step() {
         buttonPressed = true;
         pressStartTime = OS.now();
         longPressDetected = false;
+        // Come back when the press becomes a long press
+        cancel_timer(longPressTimer);
+        longPressTimer = tell_after(LONG_PRESS_TIME_MS, get_id(), EVT_BUTTON_LONG_PRESS_CHECK);
         log_debug(F("Press detected"));
     }
     // Detect button release
     else if (currentButtonState == HIGH && lastButtonState == LOW) {
         // Button just released
+        cancel_timer(longPressTimer);
         if (buttonPressed) {
             unsigned long pressDuration = OS.now() - pressStartTime;
             
@@ -9,6 +9,7 @@ public:
     YellowButtonTask();
     
     void on_start() override;
+    void on_msg(const MsgData& msg) override;
     void step() override;
     
 private:
@@ -16,4 +17,7 @@ private:
     bool buttonPressed;
     unsigned long pressStartTime;
     bool longPressDetected;
+    TimerHandle longPressTimer; // Pending EVT_BUTTON_LONG_PRESS_CHECK
+    
+    void checkButton();
 };
@@ -15,6 +15,10 @@
 #include "MBLightSensorTask.h"
 #include "DeviceRunningSensorTask.h"
 
+// Every delayed message the tasks can arm at once needs a timer slot
+static_assert(FSMOS_MAX_TIMERS >= APP_MAX_PENDING_TIMERS,
+              "FSMOS_MAX_TIMERS must cover APP_MAX_PENDING_TIMERS (Constants.h)");
+
 // Create task instances
 YellowButtonTask yellowButtonTask;
 KeypadTask keypadTask;
@@ -41,7 +45,8 @@ void setup() {
     {
         ResetInfo resetInfo;
         if (OS.get_reset_info(resetInfo)) {
-            OS.logFormatted(nullptr, LOG_INFO, F("Reset info: reason=%u lastTask=%u"), resetInfo.reset_reason, resetInfo.last_task_id);
+            OS.logFormatted(nullptr, LOG_INFO, F("Reset info: reason=%u lastTask=%u trace=%u"),
+                            resetInfo.reset_reason, resetInfo.last_task_id, resetInfo.trace_count);
         }
     }
     
@@ -65,21 +70,33 @@ void setup() {
     mbLightSensorTask.set_name(F("MBLightSensor"));
     deviceRunningSensorTask.set_name(F("DeviceRunning"));
     
-    // Add tasks
-    OS.add(&yellowButtonTask);
-    OS.add(&keypadTask);
-    OS.add(&statusLEDTask);
-    OS.add(&lightTask);
-    OS.add(&passwordManagerTask);
-    OS.add(&doorControlTask);
-    OS.add(&doorSensorTask);
-    OS.add(&eventHandlerTask);
-    OS.add(&buzzerTask);
-    OS.add(&childLockTask);
-    OS.add(&diagnosticTask);
-    OS.add(&serialCommandTask);
-    OS.add(&mbLightSensorTask);
-    OS.add(&deviceRunningSensorTask);
+    // Security-critical tasks run first when several are due together
+    OS.set_policy(SCHED_FIXED_PRIORITY);
+    doorSensorTask.set_priority(3);
+    doorControlTask.set_priority(2);
+    keypadTask.set_priority(1);
+    passwordManagerTask.set_priority(1);
+    
+    // LED events only matter for their final state; repeated identical
+    // buzzer requests in one loop play a single sound
+    OS.set_coalesce_policy(TOPIC_STATUS_LED_EVENTS, COALESCE_LATEST);
+    OS.set_coalesce_policy(TOPIC_BUZZER_EVENTS, COALESCE_DROP_IDENTICAL);
+    
+    // Register tasks (globals, so no heap allocation)
+    OS.add_static(yellowButtonTask);
+    OS.add_static(keypadTask);
+    OS.add_static(statusLEDTask);
+    OS.add_static(lightTask);
+    OS.add_static(passwordManagerTask);
+    OS.add_static(doorControlTask);
+    OS.add_static(doorSensorTask);
+    OS.add_static(eventHandlerTask);
+    OS.add_static(buzzerTask);
+    OS.add_static(childLockTask);
+    OS.add_static(diagnosticTask);
+    OS.add_static(serialCommandTask);
+    OS.add_static(mbLightSensorTask);
+    OS.add_static(deviceRunningSensorTask);
     
     OS.logMessage(nullptr, LOG_INFO, F("System initialized and ready"));
 }
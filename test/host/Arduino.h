@@ -0,0 +1,104 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino API for building FsmOS on the host
+ *
+ * Only what FsmOS.h and FsmOS.cpp use outside their __AVR__ sections.
+ * Flash strings are plain C strings, Serial writes to stdout, and time
+ * is a virtual clock that only moves when a test advances it, so runs
+ * are repeatable. The clock is atomic so that a thread standing in for
+ * an interrupt handler can read it.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <atomic>
+
+/* ================== Flash Strings ================== */
+class __FlashStringHelper;
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+typedef const char* PGM_P;
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcasecmp_P strcasecmp
+#define strncasecmp_P strncasecmp
+#define memcpy_P memcpy
+
+/* ================== Virtual Clock ================== */
+inline std::atomic<uint64_t> host_time_us{0};
+
+inline unsigned long micros() { return (uint32_t)host_time_us.load(std::memory_order_relaxed); }
+inline unsigned long millis() { return (uint32_t)(host_time_us.load(std::memory_order_relaxed) / 1000); }
+/** @brief Move the clock forward, e.g. to stand for time a step() spends */
+inline void host_advance_us(uint32_t us) { host_time_us.fetch_add(us, std::memory_order_relaxed); }
+inline void delay(unsigned long ms) { host_advance_us(ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { host_advance_us(us); }
+
+/* ================== Watchdog ================== */
+// avr/wdt.h names the scheduler uses without an __AVR__ guard
+#define WDTO_1S 6
+#define WDTO_2S 7
+inline void wdt_enable(uint8_t) {}
+inline void wdt_reset() {}
+
+/* ================== Serial ================== */
+#define DEC 10
+#define HEX 16
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+
+  size_t write(const char* s) {
+    size_t n = 0;
+    while (*s && write((uint8_t)*s++)) n++;
+    return n;
+  }
+  size_t print(const __FlashStringHelper* s) { return write((const char*)s); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(long v, int base = DEC) { return format(base == HEX ? "%lx" : "%ld", v); }
+  size_t print(unsigned long v, int base = DEC) { return format(base == HEX ? "%lx" : "%lu", v); }
+  size_t println() { return write((uint8_t)'\n'); }
+  template<typename T> size_t println(T v) { return print(v) + println(); }
+  template<typename T> size_t println(T v, int base) { return print(v, base) + println(); }
+
+private:
+  size_t format(const char* fmt, ...) {
+    char buf[24];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return write(buf);
+  }
+};
+
+class HostSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  int available() { return 0; }
+  int read() { return -1; }
+  int availableForWrite() { return 63; }
+  void flush() { fflush(stdout); }
+  operator bool() { return true; }
+  using Print::write;
+  size_t write(uint8_t c) override { return putchar(c) == EOF ? 0 : 1; }
+};
+
+inline HostSerial Serial;
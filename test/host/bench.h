@@ -0,0 +1,35 @@
+/**
+ * @file bench.h
+ * @brief Wall-clock timing for the host benchmarks in test/
+ *
+ * Host figures compare code paths with each other; they are not AVR
+ * cycle counts. Results go to stdout, which `pio test -e native -v`
+ * shows next to the Unity summary.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+/** @brief Monotonic wall time in nanoseconds */
+inline uint64_t bench_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** @brief Print one result as "BENCH <name>: <value> <unit>" */
+inline void bench_report(const char* name, double value, const char* unit) {
+  printf("BENCH %s: %.1f %s\n", name, value, unit);
+}
+
+/**
+ * @brief Keep the compiler from dropping a computed value
+ *
+ * The benchmarks are built with the env's optimisation level, so a
+ * loop whose result is unused could otherwise disappear.
+ */
+template<typename T>
+inline void bench_keep(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
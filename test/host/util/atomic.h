@@ -0,0 +1,12 @@
+/**
+ * @file atomic.h
+ * @brief Host stand-in for avr-libc's ATOMIC_BLOCK
+ *
+ * The scheduler runs on one thread in host builds, so the block needs no
+ * lock. Code shared with an interrupt (IsrSource) uses its own atomics.
+ */
+#pragma once
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 0
+#define ATOMIC_BLOCK(type) for (int _atomic_once = 1; _atomic_once; _atomic_once = 0)
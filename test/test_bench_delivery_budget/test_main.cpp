@@ -0,0 +1,132 @@
+/**
+ * @file test_main.cpp
+ * @brief loop_once() latency under a message storm, per delivery budget
+ *
+ * A handler republishes twice per message it gets (100 us each) until
+ * it has tried 2000 posts, next to a 10 ms periodic task. The bus fills
+ * up, so part of those posts are rejected; the report counts them. Runs
+ * 2 s of virtual time per budget and reports the longest loop_once()
+ * and how late the periodic task started, in virtual microseconds from
+ * its release.
+ */
+#include <Arduino.h>
+#include <FsmOS.h>
+#include <unity.h>
+#include <bench.h>
+
+static const uint8_t TOPIC_STORM = 1;
+static const uint16_t STORM_POSTS = 2000;
+static const uint32_t HANDLER_US = 100;
+static const uint16_t PERIOD_MS = 10;
+static const uint32_t PERIODIC_STEP_US = 50;
+static const uint32_t RUN_US = 2000000;
+static const uint32_t LOOP_US = 10;
+
+class Storm : public Task {
+public:
+  Storm() : Task(F("Storm")) { set_period(0); }
+  void on_start() override { subscribe(TOPIC_STORM); }
+  void step() override {}
+  void on_msg(const MsgData&) override {
+    host_advance_us(HANDLER_US);
+    for (uint8_t i = 0; i < 2 && left; i++) {
+      left--;
+      if (!publish(TOPIC_STORM, 1)) rejected++;
+    }
+  }
+
+  uint16_t left = 0;
+  uint16_t rejected = 0;
+};
+
+class Periodic : public Task {
+public:
+  Periodic() : Task(F("Periodic")) { set_period(PERIOD_MS); }
+  void on_start() override { release_ms = OS.now(); }
+  void step() override {
+    // Lateness from the release this run belongs to. Follows the
+    // scheduler's own rule: a missed release restarts from the loop time.
+    uint32_t late = micros() - release_ms * 1000UL;
+    if (late > worst_late_us) worst_late_us = late;
+    release_ms += PERIOD_MS;
+    if ((int32_t)(release_ms - OS.now()) < 0) release_ms = OS.now() + PERIOD_MS;
+    host_advance_us(PERIODIC_STEP_US);
+  }
+
+  uint32_t release_ms = 0;
+  uint32_t worst_late_us = 0;
+};
+
+struct Result {
+  uint32_t worst_loop_us;
+  uint32_t worst_late_us;
+};
+
+void setUp() {
+  host_time_us = 0;
+  OS.begin();
+}
+
+void tearDown() {}
+
+static Result run(uint8_t max_msgs, uint16_t max_us, const char* name) {
+  OS.set_delivery_budget(max_msgs, max_us);
+  Storm storm;
+  Periodic periodic;
+  OS.add_static(storm);
+  OS.add_static(periodic);
+  storm.left = STORM_POSTS;
+  storm.publish(TOPIC_STORM, 1);
+
+  Result result = { 0, 0 };
+  while (micros() < RUN_US) {
+    uint32_t start = micros();
+    OS.loop_once();
+    host_advance_us(LOOP_US);
+    if (micros() - start > result.worst_loop_us) result.worst_loop_us = micros() - start;
+  }
+
+  result.worst_late_us = periodic.worst_late_us;
+  BusStats bus;
+  OS.get_bus_stats(bus);
+  TEST_ASSERT_EQUAL_UINT16(0, storm.left);
+  TEST_ASSERT_EQUAL_UINT8(0, bus.pending);
+  OS.remove(storm.get_id());
+  OS.remove(periodic.get_id());
+
+  char label[64];
+  snprintf(label, sizeof(label), "%s worst loop_once()", name);
+  bench_report(label, result.worst_loop_us, "us");
+  snprintf(label, sizeof(label), "%s periodic task lateness", name);
+  bench_report(label, result.worst_late_us, "us");
+  snprintf(label, sizeof(label), "%s posts rejected by the full bus", name);
+  bench_report(label, storm.rejected, "msgs");
+  return result;
+}
+
+void test_unbounded() {
+  Result r = run(0, 0, "unbounded");
+  // Without a budget the storm holds the loop for many periods
+  TEST_ASSERT_GREATER_THAN(10000, r.worst_loop_us);
+  TEST_ASSERT_GREATER_THAN(10000, r.worst_late_us);
+}
+
+void test_message_budget() {
+  Result r = run(8, 0, "8 messages");
+  TEST_ASSERT_LESS_THAN(2000, r.worst_loop_us);
+  TEST_ASSERT_LESS_THAN(2000, r.worst_late_us);
+}
+
+void test_time_budget() {
+  Result r = run(0, 1000, "1000 us");
+  TEST_ASSERT_LESS_THAN(2000, r.worst_loop_us);
+  TEST_ASSERT_LESS_THAN(2000, r.worst_late_us);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_unbounded);
+  RUN_TEST(test_message_budget);
+  RUN_TEST(test_time_budget);
+  return UNITY_END();
+}
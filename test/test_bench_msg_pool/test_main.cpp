@@ -0,0 +1,124 @@
+/**
+ * @file test_main.cpp
+ * @brief Cost of posting and delivering messages through the MsgData pool
+ *
+ * Times a publish to one subscriber, a direct tell, and the pool's
+ * alloc()/free() pair next to the new/delete pair it replaced. Each
+ * test also checks that every message was delivered and that the pool
+ * ends empty, which catches reference-count leaks.
+ */
+#include <Arduino.h>
+#include <FsmOS.h>
+#include <unity.h>
+#include <bench.h>
+
+static const uint8_t TOPIC_DATA = 1;
+static const uint8_t MSG_DATA = 1;
+static const uint32_t MESSAGES = 200000;
+// Messages posted between two loop_once() calls, within the bus size
+static const uint8_t BATCH = 8;
+
+class Sink : public Task {
+public:
+  Sink() : Task(F("Sink")) { set_period(0); }
+  void on_start() override { subscribe(TOPIC_DATA); }
+  void step() override {}
+  void on_msg(const MsgData& msg) override {
+    received++;
+    sum += msg.arg;
+  }
+
+  uint32_t received = 0;
+  uint32_t sum = 0;
+};
+
+class Source : public Task {
+public:
+  Source() : Task(F("Source")) { set_period(0); }
+  void step() override {}
+};
+
+static Sink sink;
+static Source source;
+
+void setUp() {
+  OS.begin();
+  OS.add_static(sink);
+  OS.add_static(source);
+  sink.received = 0;
+  sink.sum = 0;
+}
+
+void tearDown() {
+  OS.remove(sink.get_id());
+  OS.remove(source.get_id());
+}
+
+static void check_pool_empty() {
+  MsgPoolStats pool;
+  OS.get_msg_pool_stats(pool);
+  TEST_ASSERT_EQUAL_UINT8(0, pool.in_use);
+  TEST_ASSERT_EQUAL_UINT16(0, pool.exhausted);
+}
+
+void test_publish_and_deliver() {
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; i < MESSAGES; i += BATCH) {
+    for (uint8_t j = 0; j < BATCH; j++) source.publish(TOPIC_DATA, MSG_DATA, 1);
+    OS.loop_once();
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+
+  TEST_ASSERT_EQUAL_UINT32(MESSAGES, sink.received);
+  check_pool_empty();
+  bench_report("publish+deliver", (double)elapsed / MESSAGES, "ns/msg");
+}
+
+void test_tell_and_deliver() {
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; i < MESSAGES; i += BATCH) {
+    for (uint8_t j = 0; j < BATCH; j++) source.tell(sink.get_id(), MSG_DATA, 1);
+    OS.loop_once();
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+
+  TEST_ASSERT_EQUAL_UINT32(MESSAGES, sink.received);
+  check_pool_empty();
+  bench_report("tell+deliver", (double)elapsed / MESSAGES, "ns/msg");
+}
+
+void test_pool_against_heap() {
+  static MsgPool pool;
+  MsgData* batch[BATCH];
+
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; i < MESSAGES; i += BATCH) {
+    for (uint8_t j = 0; j < BATCH; j++) batch[j] = pool.alloc();
+    bench_keep(batch);
+    for (uint8_t j = 0; j < BATCH; j++) pool.free(batch[j]);
+  }
+  uint64_t pool_ns = bench_now_ns() - start;
+
+  start = bench_now_ns();
+  for (uint32_t i = 0; i < MESSAGES; i += BATCH) {
+    for (uint8_t j = 0; j < BATCH; j++) batch[j] = new MsgData();
+    bench_keep(batch);
+    for (uint8_t j = 0; j < BATCH; j++) delete batch[j];
+  }
+  uint64_t heap_ns = bench_now_ns() - start;
+
+  MsgPoolStats stats;
+  pool.get_stats(stats);
+  TEST_ASSERT_EQUAL_UINT8(0, stats.in_use);
+  TEST_ASSERT_EQUAL_UINT8(BATCH, stats.high_water);
+  bench_report("MsgPool alloc+free", (double)pool_ns / MESSAGES, "ns/msg");
+  bench_report("new+delete MsgData", (double)heap_ns / MESSAGES, "ns/msg");
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_publish_and_deliver);
+  RUN_TEST(test_tell_and_deliver);
+  RUN_TEST(test_pool_against_heap);
+  return UNITY_END();
+}
@@ -0,0 +1,108 @@
+/**
+ * @file test_main.cpp
+ * @brief Worst-case dispatch latency of a high-priority task per policy
+ *
+ * Eight load tasks (500 us step) and one high-priority task (100 us
+ * step) all fall due every 10 ms. Steps advance the virtual clock by
+ * their cost, so each policy sees the same 10 s of simulated load and
+ * the latency is measured in virtual microseconds from the task's
+ * release to the start of its step().
+ */
+#include <Arduino.h>
+#include <FsmOS.h>
+#include <unity.h>
+#include <bench.h>
+
+static const uint16_t PERIOD_MS = 10;
+static const uint8_t LOAD_TASKS = 8;
+static const uint32_t LOAD_STEP_US = 500;
+static const uint32_t URGENT_STEP_US = 100;
+static const uint32_t RUN_US = 10000000;
+// Time loop_once() and the loop around it take per iteration
+static const uint32_t LOOP_US = 50;
+
+class Load : public Task {
+public:
+  Load() : Task(F("Load")) { set_period(PERIOD_MS); }
+  void step() override { host_advance_us(LOAD_STEP_US); }
+};
+
+class Urgent : public Task {
+public:
+  Urgent() : Task(F("Urgent")) {
+    set_period(PERIOD_MS);
+    set_priority(10);
+  }
+  void step() override {
+    // Releases are the multiples of the period since the task was added
+    uint32_t latency = (micros() - start_us) % (PERIOD_MS * 1000UL);
+    if (latency > worst_us) worst_us = latency;
+    total_us += latency;
+    runs++;
+    host_advance_us(URGENT_STEP_US);
+  }
+
+  uint32_t start_us = 0;
+  uint32_t worst_us = 0;
+  uint64_t total_us = 0;
+  uint32_t runs = 0;
+};
+
+void setUp() {
+  host_time_us = 0;
+  OS.begin();
+}
+
+void tearDown() {}
+
+/**
+ * @brief Run the load under one policy
+ * @return Worst latency of the urgent task in microseconds
+ */
+static uint32_t run(SchedulingPolicy policy, const char* name) {
+  OS.set_policy(policy);
+  Load loads[LOAD_TASKS];
+  Urgent urgent;
+  for (Load& load : loads) OS.add_static(load);
+  // Added last, so it is not first in line by accident
+  urgent.start_us = micros();
+  OS.add_static(urgent);
+
+  while (micros() < RUN_US) {
+    OS.loop_once();
+    host_advance_us(LOOP_US);
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(RUN_US / 1000 / PERIOD_MS, urgent.runs);
+  for (Load& load : loads) OS.remove(load.get_id());
+  OS.remove(urgent.get_id());
+
+  char label[48];
+  snprintf(label, sizeof(label), "%s worst latency", name);
+  bench_report(label, urgent.worst_us, "us");
+  snprintf(label, sizeof(label), "%s mean latency", name);
+  bench_report(label, (double)urgent.total_us / urgent.runs, "us");
+  return urgent.worst_us;
+}
+
+void test_edf() {
+  // Equal deadlines, so the urgent task may wait behind all the load
+  TEST_ASSERT_LESS_OR_EQUAL(LOAD_TASKS * LOAD_STEP_US + LOOP_US, run(SCHED_EDF, "EDF"));
+}
+
+void test_fixed_priority() {
+  // Never waits behind a load step that was due with it
+  TEST_ASSERT_LESS_THAN(LOAD_STEP_US, run(SCHED_FIXED_PRIORITY, "fixed priority"));
+}
+
+void test_round_robin() {
+  TEST_ASSERT_LESS_OR_EQUAL(LOAD_TASKS * LOAD_STEP_US + LOOP_US, run(SCHED_ROUND_ROBIN, "round-robin"));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_edf);
+  RUN_TEST(test_fixed_priority);
+  RUN_TEST(test_round_robin);
+  return UNITY_END();
+}
@@ -0,0 +1,107 @@
+/**
+ * @file test_main.cpp
+ * @brief Topic delivery cost against the number of tasks
+ *
+ * Two subscribers share a hot topic among 14, 50 and 64 tasks. Each
+ * size runs twice:
+ * - indexed: the topic->subscriber index holds every subscription, so
+ *   delivery only visits the topic's subscribers;
+ * - scan: two tasks subscribe to every other topic, which overflows
+ *   FSMOS_MAX_SUBSCRIPTIONS, so delivery falls back to walking the
+ *   whole task list as it did before the index.
+ * Needs FSMOS_MAX_TASKS=64, the largest task IDs allow, see
+ * [env:native_tasks].
+ */
+#include <Arduino.h>
+#include <FsmOS.h>
+#include <unity.h>
+#include <bench.h>
+
+static const uint8_t TOPIC_HOT = 1;
+static const uint8_t MSG_HOT = 1;
+static const uint32_t MESSAGES = 100000;
+static const uint8_t BATCH = 8;
+
+// The scan run's two wide tasks must not fit in the index
+static_assert(FSMOS_MAX_TASKS == 64, "Build with FSMOS_MAX_TASKS=64");
+static_assert(2 + 2 * (FSMOS_MAX_TOPICS - 2) > FSMOS_MAX_SUBSCRIPTIONS,
+              "FSMOS_MAX_SUBSCRIPTIONS too large for the scan run");
+
+class Member : public Task {
+public:
+  Member(uint8_t first_topic, uint8_t last_topic)
+    : Task(F("Member")), first_topic(first_topic), last_topic(last_topic) {
+    // Due once after add(), then not again during the run
+    set_period(60000);
+  }
+  void on_start() override {
+    for (uint8_t t = first_topic; t && t <= last_topic; t++) subscribe(t);
+  }
+  void step() override {}
+  void on_msg(const MsgData&) override { received++; }
+
+  uint32_t received = 0;
+
+private:
+  uint8_t first_topic;
+  uint8_t last_topic;
+};
+
+void setUp() {}
+
+void tearDown() {}
+
+/**
+ * @brief Time MESSAGES hot-topic messages among task_count tasks
+ * @return Nanoseconds per message, post and delivery
+ */
+static double run(uint8_t task_count, bool overflow_index) {
+  OS.begin();
+  Member* tasks[FSMOS_MAX_TASKS];
+  tasks[0] = new Member(TOPIC_HOT, TOPIC_HOT);
+  tasks[1] = new Member(TOPIC_HOT, TOPIC_HOT);
+  uint8_t wide_last = overflow_index ? FSMOS_MAX_TOPICS - 1 : TOPIC_HOT + 1;
+  tasks[2] = new Member(TOPIC_HOT + 1, wide_last);
+  tasks[3] = new Member(TOPIC_HOT + 1, wide_last);
+  for (uint8_t i = 4; i < task_count; i++) tasks[i] = new Member(0, 0);
+  for (uint8_t i = 0; i < task_count; i++) {
+    TEST_ASSERT_TRUE(OS.add(tasks[i]) != 255);
+  }
+  TEST_ASSERT_EQUAL_UINT8(task_count, OS.get_task_count());
+
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0; i < MESSAGES; i += BATCH) {
+    for (uint8_t j = 0; j < BATCH; j++) OS.post(MSG_HOT, 0, TOPIC_HOT);
+    OS.loop_once();
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+
+  TEST_ASSERT_EQUAL_UINT32(MESSAGES, tasks[0]->received);
+  TEST_ASSERT_EQUAL_UINT32(MESSAGES, tasks[1]->received);
+  TEST_ASSERT_EQUAL_UINT32(0, tasks[2]->received);
+  for (uint8_t i = 0; i < task_count; i++) {
+    OS.remove(tasks[i]->get_id());
+    delete tasks[i];
+  }
+  return (double)elapsed / MESSAGES;
+}
+
+static void compare(uint8_t task_count) {
+  char name[40];
+  snprintf(name, sizeof(name), "%u tasks, indexed", task_count);
+  bench_report(name, run(task_count, false), "ns/msg");
+  snprintf(name, sizeof(name), "%u tasks, scan", task_count);
+  bench_report(name, run(task_count, true), "ns/msg");
+}
+
+void test_14_tasks() { compare(14); }
+void test_50_tasks() { compare(50); }
+void test_64_tasks() { compare(64); }
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_14_tasks);
+  RUN_TEST(test_50_tasks);
+  RUN_TEST(test_64_tasks);
+  return UNITY_END();
+}
@@ -0,0 +1,151 @@
+/**
+ * @file test_main.cpp
+ * @brief Topic coalescing keeps each topic's message order
+ *
+ * Publishes short sequences on a coalesced topic between two
+ * loop_once() calls and checks what the subscriber receives. Only the
+ * newest pending message on the topic may absorb a post, so A, B, A
+ * must arrive as A, B, A under every policy that compares types.
+ */
+#include <Arduino.h>
+#include <FsmOS.h>
+#include <unity.h>
+
+static const uint8_t TOPIC_EVENTS = 1;
+static const uint8_t TOPIC_OTHER = 2;
+static const uint8_t MSG_A = 1;
+static const uint8_t MSG_B = 2;
+
+// Records the messages it gets, in order
+class Receiver : public Task {
+public:
+  Receiver() : Task(F("Receiver")) { set_period(0); }
+  void on_start() override {
+    subscribe(TOPIC_EVENTS);
+    subscribe(TOPIC_OTHER);
+  }
+  void step() override {}
+  void on_msg(const MsgData& msg) override {
+    if (received < 8) {
+      types[received] = msg.type;
+      counts[received] = msg.count;
+    }
+    received++;
+  }
+
+  uint8_t types[8];
+  uint8_t counts[8];
+  uint8_t received = 0;
+};
+
+class Publisher : public Task {
+public:
+  Publisher() : Task(F("Publisher")) { set_period(0); }
+  void step() override {}
+};
+
+static Receiver receiver;
+static Publisher publisher;
+
+void setUp() {
+  OS.begin();
+  OS.add_static(receiver);
+  OS.add_static(publisher);
+  receiver.received = 0;
+}
+
+void tearDown() {
+  OS.remove(receiver.get_id());
+  OS.remove(publisher.get_id());
+}
+
+static uint16_t merged() {
+  BusStats bus;
+  OS.get_bus_stats(bus);
+  return bus.merged;
+}
+
+void test_drop_identical_keeps_a_b_a() {
+  OS.set_coalesce_policy(TOPIC_EVENTS, COALESCE_DROP_IDENTICAL);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  publisher.publish(TOPIC_EVENTS, MSG_B);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  OS.loop_once();
+
+  TEST_ASSERT_EQUAL_UINT8(3, receiver.received);
+  TEST_ASSERT_EQUAL_UINT8(MSG_A, receiver.types[0]);
+  TEST_ASSERT_EQUAL_UINT8(MSG_B, receiver.types[1]);
+  TEST_ASSERT_EQUAL_UINT8(MSG_A, receiver.types[2]);
+  TEST_ASSERT_EQUAL_UINT16(0, merged());
+}
+
+void test_drop_identical_drops_repeat_of_newest() {
+  OS.set_coalesce_policy(TOPIC_EVENTS, COALESCE_DROP_IDENTICAL);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  // Other topics in between do not separate the repeats
+  publisher.publish(TOPIC_OTHER, MSG_B);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  OS.loop_once();
+
+  TEST_ASSERT_EQUAL_UINT8(2, receiver.received);
+  TEST_ASSERT_EQUAL_UINT8(MSG_A, receiver.types[0]);
+  TEST_ASSERT_EQUAL_UINT8(MSG_B, receiver.types[1]);
+  TEST_ASSERT_EQUAL_UINT16(2, merged());
+}
+
+void test_count_keeps_a_b_a() {
+  OS.set_coalesce_policy(TOPIC_EVENTS, COALESCE_COUNT);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  publisher.publish(TOPIC_EVENTS, MSG_B);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  OS.loop_once();
+
+  TEST_ASSERT_EQUAL_UINT8(3, receiver.received);
+  TEST_ASSERT_EQUAL_UINT8(MSG_A, receiver.types[0]);
+  TEST_ASSERT_EQUAL_UINT8(MSG_B, receiver.types[1]);
+  TEST_ASSERT_EQUAL_UINT8(MSG_A, receiver.types[2]);
+  TEST_ASSERT_EQUAL_UINT8(1, receiver.counts[0]);
+  TEST_ASSERT_EQUAL_UINT8(1, receiver.counts[1]);
+  TEST_ASSERT_EQUAL_UINT8(1, receiver.counts[2]);
+  TEST_ASSERT_EQUAL_UINT16(0, merged());
+}
+
+void test_count_merges_runs_of_the_newest_type() {
+  OS.set_coalesce_policy(TOPIC_EVENTS, COALESCE_COUNT);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  publisher.publish(TOPIC_EVENTS, MSG_B);
+  publisher.publish(TOPIC_EVENTS, MSG_B);
+  publisher.publish(TOPIC_EVENTS, MSG_B);
+  OS.loop_once();
+
+  TEST_ASSERT_EQUAL_UINT8(2, receiver.received);
+  TEST_ASSERT_EQUAL_UINT8(MSG_A, receiver.types[0]);
+  TEST_ASSERT_EQUAL_UINT8(2, receiver.counts[0]);
+  TEST_ASSERT_EQUAL_UINT8(MSG_B, receiver.types[1]);
+  TEST_ASSERT_EQUAL_UINT8(3, receiver.counts[1]);
+  TEST_ASSERT_EQUAL_UINT16(3, merged());
+}
+
+void test_latest_keeps_one_message_per_topic() {
+  OS.set_coalesce_policy(TOPIC_EVENTS, COALESCE_LATEST);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  publisher.publish(TOPIC_EVENTS, MSG_B);
+  publisher.publish(TOPIC_EVENTS, MSG_A);
+  OS.loop_once();
+
+  TEST_ASSERT_EQUAL_UINT8(1, receiver.received);
+  TEST_ASSERT_EQUAL_UINT8(MSG_A, receiver.types[0]);
+  TEST_ASSERT_EQUAL_UINT16(2, merged());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_drop_identical_keeps_a_b_a);
+  RUN_TEST(test_drop_identical_drops_repeat_of_newest);
+  RUN_TEST(test_count_keeps_a_b_a);
+  RUN_TEST(test_count_merges_runs_of_the_newest_type);
+  RUN_TEST(test_latest_keeps_one_message_per_topic);
+  return UNITY_END();
+}
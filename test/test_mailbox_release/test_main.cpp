@@ -0,0 +1,95 @@
+/**
+ * @file test_main.cpp
+ * @brief Messages in a task's mailbox go back to the pool when it leaves
+ *
+ * A suspended task keeps the messages published to it in its mailbox,
+ * each holding a pool slot. Removing the task, or reaping it after
+ * terminate(), must release them whether or not the scheduler owns it.
+ */
+#include <Arduino.h>
+#include <FsmOS.h>
+#include <unity.h>
+
+static const uint8_t TOPIC_DATA = 1;
+static const uint8_t MSG_DATA = 1;
+static const uint8_t QUEUED = 3;
+
+class Sleeper : public Task {
+public:
+  Sleeper() : Task(F("Sleeper")) { set_period(0); }
+  void on_start() override { subscribe(TOPIC_DATA); }
+  void step() override {}
+};
+
+class Source : public Task {
+public:
+  Source() : Task(F("Source")) { set_period(0); }
+  void step() override {}
+};
+
+static Source source;
+
+void setUp() {
+  OS.begin();
+  OS.add_static(source);
+}
+
+void tearDown() {
+  OS.remove(source.get_id());
+}
+
+static uint8_t pool_in_use() {
+  MsgPoolStats pool;
+  OS.get_msg_pool_stats(pool);
+  return pool.in_use;
+}
+
+// Suspends the task and leaves QUEUED messages in its mailbox
+static void fill_mailbox(Task& task) {
+  task.suspend();
+  for (uint8_t i = 0; i < QUEUED; i++) source.publish(TOPIC_DATA, MSG_DATA, i);
+  OS.loop_once();
+  MailboxStats mailbox;
+  OS.get_mailbox_stats(task.get_id(), mailbox);
+  TEST_ASSERT_EQUAL_UINT8(QUEUED, mailbox.pending);
+  TEST_ASSERT_EQUAL_UINT8(QUEUED, pool_in_use());
+}
+
+void test_remove_releases_mailbox() {
+  Sleeper sleeper;
+  OS.add_static(sleeper);
+  fill_mailbox(sleeper);
+
+  OS.remove(sleeper.get_id());
+  TEST_ASSERT_EQUAL_UINT8(0, pool_in_use());
+}
+
+void test_reaping_static_task_releases_mailbox() {
+  Sleeper sleeper;
+  OS.add_static(sleeper);
+  fill_mailbox(sleeper);
+
+  sleeper.terminate();
+  OS.loop_once();
+  TEST_ASSERT_NULL(OS.get_task(sleeper.get_id()));
+  TEST_ASSERT_EQUAL_UINT8(0, pool_in_use());
+}
+
+void test_reaping_owned_task_releases_mailbox() {
+  Sleeper* sleeper = new Sleeper();
+  uint8_t id = OS.add(sleeper);
+  fill_mailbox(*sleeper);
+
+  sleeper->terminate();
+  OS.loop_once();
+  TEST_ASSERT_NULL(OS.get_task(id));
+  TEST_ASSERT_EQUAL_UINT8(0, pool_in_use());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_remove_releases_mailbox);
+  RUN_TEST(test_reaping_static_task_releases_mailbox);
+  RUN_TEST(test_reaping_owned_task_releases_mailbox);
+  return UNITY_END();
+}